@@ -0,0 +1,62 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+// canonical json of deeply nested objects compared to flat ones of the same size
+// the time per byte should not depend on the depth
+//
+#include <huse/json/Serializer.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+// an object with a nested object in each of `depth` levels and `width` other members in each
+void writeNested(huse::SerializerObject& obj, int depth, int width)
+{
+    for (int i = width; i > 0; --i) obj.val(("m" + std::to_string(i)).c_str(), i);
+    if (!depth) return;
+    auto inner = obj.obj("inner");
+    writeNested(inner, depth - 1, width);
+}
+
+size_t write(bool canonical, int depth, int width)
+{
+    std::ostringstream sout;
+    {
+        huse::json::SerializerOptions opts;
+        opts.canonical = canonical;
+        auto s = huse::json::Make_Serializer(sout, opts);
+        auto root = s.root();
+        auto ar = root.ar();
+        // the same number of members in all cases
+        for (int i = 0; i < 100000 / ((depth + 1) * width); ++i)
+        {
+            auto obj = ar.obj();
+            writeNested(obj, depth, width);
+        }
+    }
+    return sout.str().size();
+}
+
+void bench(const char* name, int iterations, bool canonical, int depth, int width)
+{
+    size_t size = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) size = write(canonical, depth, width);
+    auto end = std::chrono::steady_clock::now();
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    std::printf("%-30s %10.2f ns/byte  (%zu bytes)\n", name, double(ns) / double(size) / iterations, size);
+}
+
+int main()
+{
+    const int iterations = 10;
+    bench("plain flat", iterations, false, 0, 100);
+    bench("canonical flat", iterations, true, 0, 100);
+    bench("plain depth 100", iterations, false, 100, 1);
+    bench("canonical depth 100", iterations, true, 100, 1);
+    bench("plain depth 1000", iterations, false, 1000, 1);
+    bench("canonical depth 1000", iterations, true, 1000, 1);
+    return 0;
+}
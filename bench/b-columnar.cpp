@@ -0,0 +1,122 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+// compare records written as rows and with Columns
+//
+#include <huse/helpers/Columnar.hpp>
+#include <huse/helpers/StdVector.hpp>
+#include <huse/json/Serializer.hpp>
+#include <huse/json/Deserializer.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct Trade
+{
+    std::string sym;
+    double price = 0;
+    int qty = 0;
+    std::optional<std::string> note;
+
+    bool operator==(const Trade& o) const
+    {
+        return sym == o.sym && price == o.price && qty == o.qty && note == o.note;
+    }
+
+    template <typename Node, typename Self>
+    static void sh(Node& n, Self& s)
+    {
+        auto obj = n.obj();
+        obj.val("sym", s.sym);
+        obj.val("price", s.price);
+        obj.val("qty", s.qty);
+        obj.val("note", s.note);
+    }
+    void huseSerialize(huse::SerializerNode& n) const { sh(n, *this); }
+    void huseDeserialize(huse::DeserializerNode& n) { sh(n, *this); }
+};
+
+struct Rows
+{
+    void operator()(huse::SerializerNode& n, const std::vector<Trade>& v) const { n.val(v); }
+    void operator()(huse::DeserializerNode& n, std::vector<Trade>& v) const { n.val(v); }
+};
+
+const auto Trade_Columns = huse::Columns{
+    huse::Column{"sym", &Trade::sym},
+    huse::Column{"price", &Trade::price},
+    huse::Column{"qty", &Trade::qty},
+    huse::Column{"note", &Trade::note},
+};
+
+template <typename F>
+std::string write(const std::vector<Trade>& trades, F f)
+{
+    std::ostringstream sout;
+    {
+        auto s = huse::json::Make_Serializer(sout);
+        auto root = s.root();
+        root.cval(trades, f);
+    }
+    return sout.str();
+}
+
+template <typename F>
+void read(const std::string& json, std::vector<Trade>& trades, F f)
+{
+    auto d = huse::json::Make_Deserializer(json);
+    auto root = d.root();
+    root.cval(trades, f);
+}
+
+template <typename F>
+void bench(const char* name, int iterations, F f)
+{
+    size_t check = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) check += f();
+    auto end = std::chrono::steady_clock::now();
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    std::printf("%-30s %10.2f us/iter  (%zu)\n", name, double(us) / iterations, check / size_t(iterations));
+}
+
+template <typename F>
+void benchFormat(const char* name, const std::vector<Trade>& trades, F f)
+{
+    const int iterations = 20;
+    const auto json = write(trades, f);
+    std::printf("%s: %zu bytes\n", name, json.size());
+    bench("  write", iterations, [&]() {
+        return write(trades, f).size();
+    });
+    std::vector<Trade> out;
+    bench("  read", iterations, [&]() {
+        read(json, out, f);
+        return out.size();
+    });
+    if (out != trades) std::printf("wrong values!\n");
+}
+
+int main()
+{
+    const char* syms[] = {"ABC", "XYZ", "QQQ", "LONGER_SYMBOL"};
+    std::vector<Trade> trades;
+    for (int i = 0; i < 50000; ++i)
+    {
+        auto& t = trades.emplace_back();
+        t.sym = syms[i % 4];
+        t.price = i * 0.25;
+        t.qty = i % 1000;
+        if (i % 10 == 0) t.note = "note " + std::to_string(i);
+    }
+
+    std::printf("%zu records:\n", trades.size());
+    benchFormat("rows", trades, Rows{});
+    benchFormat("Columns", trades, Trade_Columns);
+
+    return 0;
+}
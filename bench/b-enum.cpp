@@ -0,0 +1,160 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+// compare EnumAsString with hand-written if/else chains on a 200-value enum
+//
+#include <huse/helpers/EnumAsString.hpp>
+#include <huse/json/Serializer.hpp>
+#include <huse/json/Deserializer.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class Metric : int {}; // values 0-199
+
+constexpr int Num_Metrics = 200;
+
+// names like "request_latency_17": 10 groups with different lengths and 20 names in each
+struct MetricNameChars
+{
+    char data[Num_Metrics][32] = {};
+    size_t sizes[Num_Metrics] = {};
+};
+
+constexpr MetricNameChars makeMetricNameChars()
+{
+    constexpr std::string_view groups[] = {
+        "cpu", "memory", "disk_io", "network_rx", "network_tx",
+        "request_latency", "gc_pause", "queue_depth", "cache_hit_ratio", "error_rate",
+    };
+    MetricNameChars ret;
+    for (int i = 0; i < Num_Metrics; ++i)
+    {
+        auto group = groups[i / 20];
+        auto n = i % 20;
+        size_t s = 0;
+        for (char c : group) ret.data[i][s++] = c;
+        ret.data[i][s++] = '_';
+        if (n >= 10) ret.data[i][s++] = char('0' + n / 10);
+        ret.data[i][s++] = char('0' + n % 10);
+        ret.sizes[i] = s;
+    }
+    return ret;
+}
+inline constexpr MetricNameChars Metric_Name_Chars = makeMetricNameChars();
+
+constexpr std::array<huse::EnumName<Metric>, Num_Metrics> makeMetricNames()
+{
+    std::array<huse::EnumName<Metric>, Num_Metrics> ret = {};
+    for (int i = 0; i < Num_Metrics; ++i)
+    {
+        ret[i] = {Metric(i), std::string_view(Metric_Name_Chars.data[i], Metric_Name_Chars.sizes[i])};
+    }
+    return ret;
+}
+inline constexpr auto Metric_Names = makeMetricNames();
+
+// what the hand-written lambdas do
+// a loop over the names compiles to the same sequence of comparisons as an if/else chain
+// and writing is a switch which returns the name
+struct MetricIfChain
+{
+    void operator()(huse::SerializerNode& n, Metric m) const
+    {
+        n.val(Metric_Names[int(m)].name);
+    }
+
+    void operator()(huse::DeserializerNode& n, Metric& m) const
+    {
+        std::string_view str;
+        n.val(str);
+        for (auto& e : Metric_Names)
+        {
+            if (str == e.name)
+            {
+                m = e.value;
+                return;
+            }
+        }
+        n.throwException("unknown metric");
+    }
+};
+
+using MetricAsString = huse::EnumAsString<Metric_Names>;
+
+template <typename F>
+std::string write(const std::vector<Metric>& metrics, F f)
+{
+    std::ostringstream sout;
+    {
+        auto s = huse::json::Make_Serializer(sout);
+        auto root = s.root();
+        auto ar = root.ar();
+        for (auto m : metrics) ar.cval(m, f);
+    }
+    return sout.str();
+}
+
+template <typename F>
+void read(const std::string& json, std::vector<Metric>& metrics, F f)
+{
+    auto d = huse::json::Make_Deserializer(json);
+    auto root = d.root();
+    auto ar = root.ar();
+    metrics.resize(ar.length());
+    for (auto& m : metrics) ar.cval(m, f);
+}
+
+template <typename F>
+void bench(const char* name, int iterations, F f)
+{
+    size_t check = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) check += f();
+    auto end = std::chrono::steady_clock::now();
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    std::printf("%-30s %10.2f us/iter  (%zu)\n", name, double(us) / iterations, check / size_t(iterations));
+}
+
+int main()
+{
+    // uniformly distributed values, so the if-chain is not helped by a lucky order
+    std::vector<Metric> metrics;
+    uint32_t rnd = 12345;
+    for (int i = 0; i < 100000; ++i)
+    {
+        rnd = rnd * 1664525 + 1013904223;
+        metrics.push_back(Metric((rnd >> 8) % Num_Metrics));
+    }
+
+    const int iterations = 20;
+    std::printf("%zu values:\n", metrics.size());
+
+    bench("write if-chain", iterations, [&]() {
+        return write(metrics, MetricIfChain{}).size();
+    });
+    bench("write EnumAsString", iterations, [&]() {
+        return write(metrics, MetricAsString{}).size();
+    });
+
+    const auto json = write(metrics, MetricAsString{});
+    if (json != write(metrics, MetricIfChain{})) std::printf("different output!\n");
+
+    std::vector<Metric> read1, read2;
+    bench("read if-chain", iterations, [&]() {
+        read(json, read1, MetricIfChain{});
+        return read1.size();
+    });
+    bench("read EnumAsString", iterations, [&]() {
+        read(json, read2, MetricAsString{});
+        return read2.size();
+    });
+    if (read1 != metrics || read2 != metrics) std::printf("wrong values!\n");
+
+    return 0;
+}
@@ -0,0 +1,108 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+// compare serializing to a growing buffer with counting the size first and
+// serializing to a buffer of the exact size
+//
+#include <huse/CountingStream.hpp>
+#include <huse/json/Serializer.hpp>
+#include <huse/helpers/StdVector.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct Order
+{
+    int id;
+    std::string customer;
+    std::vector<double> prices;
+    std::vector<int> quantities;
+
+    void huseSerialize(huse::SerializerNode& n) const
+    {
+        auto o = n.obj();
+        o.val("id", id);
+        o.val("customer", customer);
+        o.val("prices", prices);
+        o.val("quantities", quantities);
+    }
+};
+
+struct Batch
+{
+    std::vector<Order> orders;
+
+    void huseSerialize(huse::SerializerNode& n) const
+    {
+        auto ar = n.ar();
+        for (auto& o : orders) ar.val(o);
+    }
+};
+
+Batch makeBatch(int numOrders)
+{
+    Batch ret;
+    for (int i = 0; i < numOrders; ++i)
+    {
+        auto& o = ret.orders.emplace_back();
+        o.id = i;
+        o.customer = "customer \"" + std::to_string(i * 7919) + "\"";
+        for (int j = 0; j < 10; ++j)
+        {
+            o.prices.push_back(j * 1.25 + i);
+            o.quantities.push_back(i * j);
+        }
+    }
+    return ret;
+}
+
+template <typename F>
+void bench(const char* name, int iterations, F f)
+{
+    size_t check = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) check += f();
+    auto end = std::chrono::steady_clock::now();
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    std::printf("%-30s %10.2f us/iter  (%zu)\n", name, double(us) / iterations, check / size_t(iterations));
+}
+
+int main()
+{
+    for (int numOrders : {10, 1000, 100000})
+    {
+        auto batch = makeBatch(numOrders);
+        const int iterations = numOrders >= 100000 ? 5 : 100000 / numOrders;
+
+        std::printf("%d orders:\n", numOrders);
+
+        bench("ostringstream", iterations, [&]() {
+            std::ostringstream sout;
+            {
+                auto s = huse::json::Make_Serializer(sout);
+                auto root = s.root();
+                root.val(batch);
+            }
+            return sout.str().size();
+        });
+
+        bench("serializedSize", iterations, [&]() {
+            return size_t(huse::serializedSize(batch));
+        });
+
+        bench("serializeExact", iterations, [&]() {
+            return huse::serializeExact(batch).size();
+        });
+
+        // the slot is reused like a shared memory slot or a network frame
+        std::vector<char> slot(size_t(huse::serializedSize(batch)));
+        bench("serializeTo (preallocated)", iterations, [&]() {
+            return huse::serializeTo(slot.data(), slot.size(), batch);
+        });
+    }
+
+    return 0;
+}
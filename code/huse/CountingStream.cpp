@@ -0,0 +1,68 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include "CountingStream.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace huse
+{
+
+CountingStreambuf::CountingStreambuf()
+{
+    reset();
+}
+
+void CountingStreambuf::reset()
+{
+    m_total = 0;
+    setp(m_scratch, m_scratch + Scratch_Size);
+}
+
+CountingStreambuf::int_type CountingStreambuf::overflow(int_type ch)
+{
+    m_total += uint64_t(pptr() - pbase());
+    setp(m_scratch, m_scratch + Scratch_Size);
+    if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+    return ch;
+}
+
+std::streamsize CountingStreambuf::xsputn(const char_type*, std::streamsize num)
+{
+    // no copying
+    m_total += uint64_t(num);
+    return num;
+}
+
+FixedBufferStreambuf::FixedBufferStreambuf(char* buf, size_t size)
+{
+    setp(buf, buf + size);
+}
+
+FixedBufferStreambuf::int_type FixedBufferStreambuf::overflow(int_type ch)
+{
+    if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+    ++m_dropped;
+    return ch;
+}
+
+std::streamsize FixedBufferStreambuf::xsputn(const char_type* s, std::streamsize num)
+{
+    auto fit = std::min(num, std::streamsize(epptr() - pptr()));
+    std::memcpy(pptr(), s, size_t(fit));
+    m_dropped += uint64_t(num - fit);
+
+    // pbump takes an int
+    for (auto left = fit; left > 0; )
+    {
+        auto step = left > 0x40000000 ? 0x40000000 : int(left);
+        pbump(step);
+        left -= step;
+    }
+    return num;
+}
+
+}
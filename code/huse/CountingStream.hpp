@@ -0,0 +1,113 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "API.h"
+#include "Exception.hpp"
+#include "Serializer.hpp"
+#include "json/Serializer.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+namespace huse
+{
+
+// a streambuf which discards everything written to it and only counts the bytes
+// use it as the output of a serializer to get the exact size of the serialized form
+class HUSE_API CountingStreambuf : public std::streambuf
+{
+public:
+    CountingStreambuf();
+
+    // number of bytes written so far
+    uint64_t size() const { return m_total + uint64_t(pptr() - pbase()); }
+
+    void reset();
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char_type* s, std::streamsize num) override;
+
+private:
+    uint64_t m_total;
+
+    // single characters land here so that they don't cost a virtual call each
+    static constexpr std::streamsize Scratch_Size = 256;
+    char m_scratch[Scratch_Size];
+};
+
+// a streambuf which writes to a fixed buffer
+// bytes which don't fit are dropped (and counted)
+// it never throws, since serializers write closing brackets from destructors
+class HUSE_API FixedBufferStreambuf : public std::streambuf
+{
+public:
+    FixedBufferStreambuf(char* buf, size_t size);
+
+    // number of bytes written to the buffer
+    size_t size() const { return size_t(pptr() - pbase()); }
+
+    // true if some bytes didn't fit
+    bool overflowed() const { return m_dropped != 0; }
+
+    // number of bytes which would have been written with a big enough buffer
+    uint64_t requiredSize() const { return size() + m_dropped; }
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char_type* s, std::streamsize num) override;
+
+private:
+    uint64_t m_dropped = 0;
+};
+
+// exact size of the json which the object serializes to
+template <typename T>
+uint64_t serializedSize(const T& obj, bool pretty = false)
+{
+    CountingStreambuf count;
+    std::ostream out(&count);
+    {
+        auto s = json::Make_Serializer(out, pretty);
+        auto root = s.root();
+        root.val(obj);
+    }
+    return count.size();
+}
+
+// serialize the object to a fixed buffer and return the number of bytes written
+// throws SerializerException with ErrorCode::OutOfRange if it doesn't fit
+// (the contents of the buffer are unspecified in this case)
+template <typename T>
+size_t serializeTo(char* buf, size_t size, const T& obj, bool pretty = false)
+{
+    FixedBufferStreambuf fixed(buf, size);
+    std::ostream out(&fixed);
+    {
+        auto s = json::Make_Serializer(out, pretty);
+        auto root = s.root();
+        root.val(obj);
+    }
+    if (fixed.overflowed())
+    {
+        throw SerializerException(ErrorCode::OutOfRange, "Output doesn't fit in the buffer. Required size: "
+            + std::to_string(fixed.requiredSize()));
+    }
+    return fixed.size();
+}
+
+// serialize the object to a string allocated once at the exact size
+// this makes two serialization passes: one to count the bytes and one to write them
+template <typename T>
+std::string serializeExact(const T& obj, bool pretty = false)
+{
+    std::string ret;
+    ret.resize(size_t(serializedSize(obj, pretty)));
+    serializeTo(ret.data(), ret.size(), obj, pretty);
+    return ret;
+}
+
+}
@@ -5,18 +5,44 @@
 #include "API.h"
 #include "DeserializerInterface.hpp"
 #include "DeserializerObj.hpp"
+#include "Exception.hpp"
+#include "KeyShape.hpp"
+#include "JsonPointer.hpp"
 
 #include "impl/UniqueStack.hpp"
 
+#include <msstl/charconv.hpp>
+
 #include <string_view>
+#include <string>
 #include <optional>
 #include <iosfwd>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
 
 namespace huse
 {
 class DeserializerArray;
 class DeserializerObject;
 
+namespace impl
+{
+// std::pmr values which are constructed while reading get the memory resource of the
+// deserializer, unless their container is a std::pmr one, which gives them its own
+template <typename T>
+inline constexpr bool UsesMemoryResource = std::uses_allocator_v<T, std::pmr::polymorphic_allocator<char>>;
+template <typename T, typename Container = void>
+inline constexpr bool NeedsMemoryResource = UsesMemoryResource<T> && !UsesMemoryResource<Container>;
+
+template <typename T>
+T& emplaceNew(const Deserializer& d, std::optional<T>& opt)
+{
+    if constexpr (NeedsMemoryResource<T>) return opt.emplace(d.memoryResource());
+    else return opt.emplace();
+}
+} // namespace impl
+
 class DeserializerSStream : public impl::UniqueStack
 {
 public:
@@ -59,6 +85,115 @@ private:
     std::istream* m_stream;
 };
 
+// a lightweight alternative to DeserializerSStream
+// parses numbers and whitespace-delimited tokens directly out of a string value
+// no std::istream is involved, so there is no stream or locale construction per value
+// the value is referenced, not copied, thus the scanner must not outlive the deserializer
+class DeserializerScanner
+{
+public:
+    DeserializerScanner(Deserializer& d, std::string_view str)
+        : m_deserializer(d)
+        , m_str(str)
+    {}
+
+    template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+    DeserializerScanner& operator>>(T& t)
+    {
+        skipws();
+        if constexpr (std::is_same_v<T, char>)
+        {
+            // like std::istream: the next non-whitespace character
+            if (m_str.empty()) throwException("unexpected end of string");
+            t = m_str.front();
+            m_str.remove_prefix(1);
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+        {
+            // like std::istream with no boolalpha: 0 or 1
+            int i;
+            *this >> i;
+            if (i != 0 && i != 1) throwException("not a boolean");
+            t = !!i;
+        }
+        else
+        {
+            auto end = m_str.data() + m_str.size();
+            auto res = msstl::from_chars(m_str.data(), end, t);
+            if (res.ec != std::errc{}) throwException("not a number");
+            m_str.remove_prefix(size_t(res.ptr - m_str.data()));
+        }
+        return *this;
+    }
+
+    // whitespace-delimited token (points inside the value)
+    DeserializerScanner& operator>>(std::string_view& token)
+    {
+        skipws();
+        size_t len = 0;
+        while (len < m_str.size() && !isws(m_str[len])) ++len;
+        token = m_str.substr(0, len);
+        m_str.remove_prefix(len);
+        return *this;
+    }
+
+    DeserializerScanner& operator>>(std::string& token)
+    {
+        std::string_view sv;
+        *this >> sv;
+        token.assign(sv.data(), sv.size());
+        return *this;
+    }
+
+    template <typename T>
+    DeserializerScanner& operator&(T& t)
+    {
+        return *this >> t;
+    }
+
+    // skip whitespace and consume the delimiter c or throw if the next character is different
+    DeserializerScanner& expect(char c)
+    {
+        skipws();
+        if (m_str.empty() || m_str.front() != c)
+        {
+            throwException(std::string("expected '") + c + '\'');
+        }
+        m_str.remove_prefix(1);
+        return *this;
+    }
+
+    // skip whitespace and consume the delimiter c if it's next
+    bool skip(char c)
+    {
+        skipws();
+        if (m_str.empty() || m_str.front() != c) return false;
+        m_str.remove_prefix(1);
+        return true;
+    }
+
+    void skipws()
+    {
+        while (!m_str.empty() && isws(m_str.front())) m_str.remove_prefix(1);
+    }
+
+    // the rest of the value which hasn't been scanned yet
+    std::string_view rest() const { return m_str; }
+
+    bool eof() const { return m_str.empty(); }
+
+    [[noreturn]] void throwException(const std::string& msg) const;
+
+private:
+    static bool isws(char c)
+    {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    Deserializer& m_deserializer;
+    std::string_view m_str;
+};
+
 class DeserializerNode : public impl::UniqueStack
 {
 protected:
@@ -82,6 +217,12 @@ public:
     DeserializerObject obj();
     DeserializerArray ar();
 
+    // values are read into the existing object
+    // strings, containers, and optionals reuse their memory when they can:
+    // * vectors read into their existing elements, but shrinking destroys the ones past the
+    //   new length (see VectorLike)
+    // * maps read into the entries of keys which they already have and keep the entries of
+    //   keys which are not in the input (see MapLike)
     template <typename T>
     void val(T& v);
 
@@ -96,6 +237,27 @@ public:
         return DeserializerSStream(m_deserializer, this);
     }
 
+    DeserializerScanner scanner();
+
+    // read the next value and return its exact json source
+    // only available if the backend retains its source (see json::DeserializerOptions::retainSource)
+    std::string_view raw();
+
+    // capture the position of the deserializer, so that values can be read again
+    // restore must be called on a node in the same compound and undoes all reads since the bookmark
+    // (it throws ErrorCode::OutOfRange otherwise)
+    // throws ErrorCode::Unsupported for backends which can't rewind
+    DeserializerBookmark bookmark() const;
+    void restore(const DeserializerBookmark& b);
+
+    // a handle which keeps values read by reference (like std::string_view) valid after the
+    // deserializer is destroyed (see helpers/Borrowed.hpp)
+    DocumentRef documentRef();
+
+    // skip the value, but keep a handle with which it can be read later (see Lazy.hpp)
+    // throws ErrorCode::Unsupported for backends which don't support it
+    DetachedValue detach();
+
     void skip();
 
     bool end() const;
@@ -104,7 +266,7 @@ public:
 
 protected:
     // number of elements in compound object
-    int length() const;
+    size_t length() const;
 };
 
 class DeserializerArray : public DeserializerNode
@@ -114,7 +276,7 @@ public:
     ~DeserializerArray();
 
     using DeserializerNode::length;
-    DeserializerNode& index(int index);
+    DeserializerNode& index(size_t index);
 
     // intentionally hiding parent
     Type type() const { return { Type::Array }; }
@@ -138,6 +300,8 @@ public:
     using DeserializerNode::length;
     using DeserializerNode::end;
     using DeserializerNode::throwException;
+    using DeserializerNode::bookmark;
+    using DeserializerNode::restore;
 
     DeserializerNode& key(std::string_view k);
 
@@ -163,7 +327,7 @@ public:
     {
         if (auto open = optkey(k))
         {
-            open->val(v.emplace());
+            open->val(v ? *v : impl::emplaceNew(m_deserializer, v)); // reuse the current value
         }
         else
         {
@@ -185,11 +349,11 @@ public:
     {
         if (auto open = optkey(k))
         {
-            open->val(v.emplace());
+            open->val(v ? *v : impl::emplaceNew(m_deserializer, v)); // reuse the current value
         }
         else
         {
-            v.reset(d);
+            v = d;
         }
     }
 
@@ -207,7 +371,7 @@ public:
     {
         if (auto open = optkey(k))
         {
-            open->cval(v.emplace(), std::forward<F>(f));
+            open->cval(v ? *v : impl::emplaceNew(m_deserializer, v), std::forward<F>(f)); // reuse the current value
         }
         else
         {
@@ -229,6 +393,25 @@ public:
         return std::nullopt;
     }
 
+    DeserializerScanner scanner(std::string_view k)
+    {
+        return key(k).scanner();
+    }
+
+    std::optional<DeserializerScanner> optscanner(std::string_view k)
+    {
+        if (auto open = optkey(k))
+        {
+            return open->scanner();
+        }
+        return std::nullopt;
+    }
+
+    std::string_view raw(std::string_view k)
+    {
+        return key(k).raw();
+    }
+
     struct KeyQuery
     {
         std::string_view name;
@@ -241,8 +424,19 @@ public:
     template <typename Key, typename T>
     void nextkeyval(Key& k, T& v);
 
+    // use (and update) the learned key layout for the following key lookups
+    void shape(KeyShape& s)
+    {
+        m_shape = &s;
+        m_shapeSlot = 0;
+    }
+
     // intentionally hiding parent
     Type type() const { return { Type::Object }; }
+
+private:
+    KeyShape* m_shape = nullptr;
+    size_t m_shapeSlot = 0;
 };
 
 inline DeserializerSStream::DeserializerSStream(Deserializer& d, impl::UniqueStack* parent)
@@ -260,6 +454,10 @@ inline void DeserializerSStream::throwException(const std::string& msg) const {
     throwDeserializerException_msg::call(m_deserializer, msg);
 }
 
+inline void DeserializerScanner::throwException(const std::string& msg) const {
+    throwDeserializerException_msg::call(m_deserializer, msg);
+}
+
 inline DeserializerObject DeserializerNode::obj()
 {
     return DeserializerObject(m_deserializer, this);
@@ -325,11 +523,48 @@ inline Type DeserializerNode::type() const
     return pendingType_msg::call(m_deserializer);
 }
 
-inline int DeserializerNode::length() const
+inline size_t DeserializerNode::length() const
 {
     return curLength_msg::call(m_deserializer);
 }
 
+inline DeserializerScanner DeserializerNode::scanner()
+{
+    std::string_view str;
+    val(str);
+    return DeserializerScanner(m_deserializer, str);
+}
+
+inline std::string_view DeserializerNode::raw()
+{
+    return loadRawJson_msg::call(m_deserializer);
+}
+
+inline DeserializerBookmark DeserializerNode::bookmark() const
+{
+    return bookmark_msg::call(m_deserializer);
+}
+
+inline void DeserializerNode::restore(const DeserializerBookmark& b)
+{
+    restore_msg::call(m_deserializer, b);
+}
+
+inline DocumentRef DeserializerNode::documentRef()
+{
+    return documentRef_msg::call(m_deserializer);
+}
+
+inline DetachedValue DeserializerNode::detach()
+{
+    return detach_msg::call(m_deserializer);
+}
+
+inline Deserializer DetachedValue::deserializer() const
+{
+    return m_factory(*this);
+}
+
 inline void DeserializerNode::skip()
 {
     skip_msg::call(m_deserializer);
@@ -351,7 +586,7 @@ inline DeserializerArray::~DeserializerArray()
     unloadArray_msg::call(m_deserializer);
 }
 
-inline DeserializerNode& DeserializerArray::index(int index)
+inline DeserializerNode& DeserializerArray::index(size_t index)
 {
     loadIndex_msg::call(m_deserializer, index);
     return *this;
@@ -375,12 +610,23 @@ inline DeserializerObject::~DeserializerObject()
 
 inline DeserializerNode& DeserializerObject::key(std::string_view k)
 {
+    if (m_shape)
+    {
+        auto& hint = m_shape->hint(m_shapeSlot++);
+        if (tryLoadKeyHinted_msg::call(m_deserializer, k, hint)) return *this;
+    }
     loadKey_msg::call(m_deserializer, k);
     return *this;
 }
 
 inline DeserializerNode* DeserializerObject::optkey(std::string_view k)
 {
+    if (m_shape)
+    {
+        auto& hint = m_shape->hint(m_shapeSlot++);
+        if (tryLoadKeyHinted_msg::call(m_deserializer, k, hint)) return this;
+        return nullptr;
+    }
     if (tryLoadKey_msg::call(m_deserializer, k)) return this;
     return nullptr;
 }
@@ -395,7 +641,9 @@ inline DeserializerObject::KeyQuery DeserializerObject::peeknext()
 template <typename Key, typename T>
 void DeserializerObject::nextkeyval(Key& k, T& v)
 {
-    k = Key(pendingKey_msg::call(m_deserializer));
+    // assign in place when possible to keep the memory (and allocator) of the key
+    if constexpr (std::is_assignable_v<Key&, std::string_view>) k = pendingKey_msg::call(m_deserializer);
+    else k = Key(pendingKey_msg::call(m_deserializer));
     this->DeserializerNode::val(v);
 }
 
@@ -416,11 +664,63 @@ void DeserializerObject::flatval(T& v)
     }
 }
 
+// the result of Deserializer::tryVal
+// it shares the error with the deserializer, but doesn't refer to the deserializer itself,
+// so it can outlive it
+class DeserializerResult
+{
+public:
+    DeserializerResult() = default;
+    explicit DeserializerResult(std::shared_ptr<const DeserializerException> error)
+        : m_error(std::move(error))
+    {}
+
+    ErrorCode code() const { return m_error ? m_error->code() : ErrorCode::None; }
+    explicit operator bool() const { return !m_error; }
+
+    // null on success
+    const std::shared_ptr<const DeserializerException>& error() const { return m_error; }
+
+    // the path and the message, formatted on the first call
+    // empty on success
+    std::string_view text() const { return m_error ? m_error->what() : std::string_view{}; }
+
+private:
+    std::shared_ptr<const DeserializerException> m_error;
+};
+
+template <typename T>
+DeserializerResult Deserializer::tryVal(T& v)
+{
+    try
+    {
+        root().val(v);
+    }
+    catch (DeserializerException& e)
+    {
+        // an error recorded before the throw is the real cause
+        if (auto error = error_msg::call(*this)) return DeserializerResult(std::move(error));
+        return DeserializerResult(std::make_shared<DeserializerException>(std::move(e)));
+    }
+    // nothing is formatted here: the text is formatted when it's requested
+    return DeserializerResult(error_msg::call(*this));
+}
+
 inline DeserializerNode Deserializer::node() {
     return DeserializerNode(*this, nullptr);
 }
 
 inline DeserializerNode Deserializer::root() {
+    loadPointer_msg::call(*this, JsonPointer{});
+    return node();
+}
+
+inline DeserializerNode Deserializer::at(std::string_view pointer) {
+    return at(JsonPointer(pointer));
+}
+
+inline DeserializerNode Deserializer::at(const JsonPointer& pointer) {
+    loadPointer_msg::call(*this, pointer);
     return node();
 }
 
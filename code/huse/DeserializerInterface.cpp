@@ -5,6 +5,7 @@
 #include "DefineMsg.hpp"
 #include "DeserializerObj.hpp"
 #include "Exception.hpp"
+#include "JsonPointer.hpp"
 
 namespace huse {
 HUSE_DEFINE_D_MSG(bool, bool);
@@ -32,12 +33,62 @@ DYNAMIX_DEFINE_SIMPLE_MSG_EX(unloadArray_msg, unicast, false, nullptr);
 DYNAMIX_DEFINE_SIMPLE_MSG_EX(curLength_msg, unicast, false, nullptr);
 DYNAMIX_DEFINE_SIMPLE_MSG_EX(loadKey_msg, unicast, false, nullptr);
 DYNAMIX_DEFINE_SIMPLE_MSG_EX(tryLoadKey_msg, unicast, false, nullptr);
+bool tryLoadKeyHintedDefault(Deserializer& d, std::string_view key, size_t&) {
+    return tryLoadKey_msg::call(d, key);
+}
+DYNAMIX_DEFINE_SIMPLE_MSG_EX(tryLoadKeyHinted_msg, unicast, true, tryLoadKeyHintedDefault);
 DYNAMIX_DEFINE_SIMPLE_MSG_EX(loadIndex_msg, unicast, false, nullptr);
 DYNAMIX_DEFINE_SIMPLE_MSG_EX(hasPending_msg, unicast, false, nullptr);
 DYNAMIX_DEFINE_SIMPLE_MSG_EX(pendingType_msg, unicast, false, nullptr);
 DYNAMIX_DEFINE_SIMPLE_MSG_EX(pendingKey_msg, unicast, false, nullptr);
 DYNAMIX_DEFINE_SIMPLE_MSG_EX(optPendingKey_msg, unicast, false, nullptr);
 
+bool hasRawJsonDefault(const Deserializer&) {
+    return false;
+}
+DYNAMIX_DEFINE_SIMPLE_MSG_EX(hasRawJson_msg, unicast, true, hasRawJsonDefault);
+
+std::string_view loadRawJsonDefault(Deserializer&) {
+    throw DeserializerException(ErrorCode::Unsupported, "raw json is not supported");
+}
+DYNAMIX_DEFINE_SIMPLE_MSG_EX(loadRawJson_msg, unicast, true, loadRawJsonDefault);
+
+void loadPointerDefault(Deserializer&, const JsonPointer& ptr) {
+    if (ptr.empty()) return;
+    throw DeserializerException(ErrorCode::Unsupported, "json pointers are not supported");
+}
+DYNAMIX_DEFINE_SIMPLE_MSG_EX(loadPointer_msg, unicast, true, loadPointerDefault);
+
+DeserializerBookmark bookmarkDefault(const Deserializer&) {
+    throw DeserializerException(ErrorCode::Unsupported, "bookmarks are not supported");
+}
+DYNAMIX_DEFINE_SIMPLE_MSG_EX(bookmark_msg, unicast, true, bookmarkDefault);
+
+void restoreDefault(Deserializer&, const DeserializerBookmark&) {
+    throw DeserializerException(ErrorCode::Unsupported, "bookmarks are not supported");
+}
+DYNAMIX_DEFINE_SIMPLE_MSG_EX(restore_msg, unicast, true, restoreDefault);
+
+DocumentRef documentRefDefault(Deserializer&) {
+    throw DeserializerException(ErrorCode::Unsupported, "document refs are not supported");
+}
+DYNAMIX_DEFINE_SIMPLE_MSG_EX(documentRef_msg, unicast, true, documentRefDefault);
+
+DetachedValue detachDefault(Deserializer&) {
+    throw DeserializerException(ErrorCode::Unsupported, "detached values are not supported");
+}
+DYNAMIX_DEFINE_SIMPLE_MSG_EX(detach_msg, unicast, true, detachDefault);
+
+ErrorCode errorCodeDefault(const Deserializer&) {
+    return ErrorCode::None;
+}
+DYNAMIX_DEFINE_SIMPLE_MSG_EX(errorCode_msg, unicast, true, errorCodeDefault);
+
+std::shared_ptr<const DeserializerException> errorDefault(const Deserializer&) {
+    return {};
+}
+DYNAMIX_DEFINE_SIMPLE_MSG_EX(error_msg, unicast, true, errorDefault);
+
 void throwDeserializerExceptionDefault(const Deserializer&, const std::string& msg) {
     throw DeserializerException(msg);
 }
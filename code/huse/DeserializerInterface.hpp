@@ -5,13 +5,102 @@
 #include "API.h"
 #include "DeclareMsg.hpp"
 #include "Type.hpp"
+#include "ErrorCode.hpp"
 
 #include <string_view>
+#include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <iosfwd>
 #include <string>
+#include <memory>
+#include <new>
+#include <type_traits>
 
 namespace huse {
+
+class JsonPointer;
+class Deserializer;
+class DeserializerException;
+
+// an opaque snapshot of the position of a deserializer
+// only the backend which created it can interpret it
+// the state is stored inline, so making a bookmark doesn't allocate
+class DeserializerBookmark
+{
+public:
+    static constexpr size_t Max_State_Size = 16 * sizeof(void*);
+
+    DeserializerBookmark() = default;
+
+    template <typename State>
+    DeserializerBookmark(const void* owner, const State& state)
+        : m_owner(owner)
+    {
+        static_assert(std::is_trivially_copyable_v<State>, "bookmark state must be trivially copyable");
+        static_assert(sizeof(State) <= Max_State_Size, "bookmark state is too big");
+        static_assert(alignof(State) <= alignof(std::max_align_t), "bookmark state is overaligned");
+        new (m_state) State(state);
+    }
+
+    explicit operator bool() const { return !!m_owner; }
+
+    const void* owner() const { return m_owner; }
+
+    template <typename T>
+    const T& state() const { return *std::launder(reinterpret_cast<const T*>(m_state)); }
+
+private:
+    const void* m_owner = nullptr;
+    alignas(std::max_align_t) unsigned char m_state[Max_State_Size];
+};
+
+// keeps the memory of values which were read by reference (like std::string_view) alive after
+// the deserializer is destroyed
+// an empty ref means that this memory belongs to the input of the deserializer (which the user owns)
+using DocumentRef = std::shared_ptr<const void>;
+
+// a value which was skipped without being deserialized and can be read later by a new
+// deserializer (see DeserializerNode::detach and Lazy.hpp)
+// it keeps the parsed document alive (all of it, not only the value) through its ref
+// if the ref is empty, the document belongs to the user and must outlive the value
+// only the backend which created it can interpret it
+class DetachedValue
+{
+public:
+    using Factory = Deserializer(*)(const DetachedValue&);
+
+    DetachedValue() = default;
+    DetachedValue(Factory factory, DocumentRef ref, const void* value, uintptr_t tag, std::string_view source)
+        : m_factory(factory)
+        , m_ref(std::move(ref))
+        , m_value(value)
+        , m_tag(tag)
+        , m_source(source)
+    {}
+
+    explicit operator bool() const { return !!m_factory; }
+
+    // a new deserializer whose root is the value (must not be empty)
+    // implemented in Deserializer.hpp
+    Deserializer deserializer() const;
+
+    const DocumentRef& ref() const { return m_ref; }
+    const void* value() const { return m_value; }
+    uintptr_t tag() const { return m_tag; }
+
+    // the source of the value if it's json with a retained source (empty otherwise)
+    // it refers to the input of the original deserializer and isn't kept alive by the ref
+    std::string_view source() const { return m_source; }
+
+private:
+    Factory m_factory = nullptr;
+    DocumentRef m_ref;
+    const void* m_value = nullptr;
+    uintptr_t m_tag = 0;
+    std::string_view m_source;
+};
+
 HUSE_D_MSG(HUSE_API, bool, bool);
 HUSE_D_MSG(HUSE_API, short, short);
 HUSE_D_MSG(HUSE_API, unsigned short, ushort);
@@ -42,7 +131,7 @@ DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, loadArray_msg, void(Deserializer&)
 DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, unloadArray_msg, void(Deserializer&));
 
 // number of sub-nodes in current node
-DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, curLength_msg, int(const Deserializer&));
+DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, curLength_msg, size_t(const Deserializer&));
 
 // throw if no key
 DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, loadKey_msg, void(Deserializer&, std::string_view key));
@@ -52,8 +141,13 @@ DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, loadKey_msg, void(Deserializer&, s
 // if (hasKey(k)) { loadKey(k); return true; } else return false;
 DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, tryLoadKey_msg, bool(Deserializer&, std::string_view key));
 
+// same as tryLoadKey, but first check the key at index hint (if it's in range)
+// on success hint is set to the index of the key
+// the default implementation ignores the hint
+DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, tryLoadKeyHinted_msg, bool(Deserializer&, std::string_view key, size_t& hint));
+
 // throw if no index
-DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, loadIndex_msg, void(Deserializer&, int index));
+DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, loadIndex_msg, void(Deserializer&, size_t index));
 
 DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, hasPending_msg, bool(const Deserializer&));
 
@@ -65,6 +159,44 @@ DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, pendingKey_msg, std::string_view(c
 // return pending key or nullopt if there is none
 DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, optPendingKey_msg, std::optional<std::string_view>(const Deserializer&));
 
+// raw json
+// backends which read json and have its source text can return the exact source of a value
+// has a default implementation (default impl returns false)
+DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, hasRawJson_msg, bool(const Deserializer&));
+// read the next value and return its source
+// has a default implementation (default impl throws)
+DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, loadRawJson_msg, std::string_view(Deserializer&));
+
+// make the value at the pointer the root (an empty pointer restores the document root)
+// only valid when no nodes are open
+// has a default implementation (default impl throws for non-empty pointers)
+DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, loadPointer_msg, void(Deserializer&, const JsonPointer&));
+
+// bookmarks
+// backends which can rewind can capture their position and restore it later to read values again
+// a bookmark can only be restored in the same compound in which it was made
+// (restoring it elsewhere throws ErrorCode::OutOfRange)
+// default implementations throw (for backends which can't rewind)
+DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, bookmark_msg, DeserializerBookmark(const Deserializer&));
+DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, restore_msg, void(Deserializer&, const DeserializerBookmark&));
+
+// document ref (see DocumentRef)
+// has a default implementation (default impl throws)
+DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, documentRef_msg, DocumentRef(Deserializer&));
+
+// read the next value as a detached value (see DetachedValue)
+// has a default implementation (default impl throws)
+DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, detach_msg, DetachedValue(Deserializer&));
+
+// error state
+// backends can be configured to record the first error instead of throwing
+// after an error is recorded, all reads are no-ops
+// default implementations: no error, empty text
+DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, errorCode_msg, ErrorCode(const Deserializer&));
+// the recorded error (null if there is none)
+// it's shared, so it can outlive the deserializer, and its text is only formatted on demand
+DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, error_msg, std::shared_ptr<const DeserializerException>(const Deserializer&));
+
 // optional override
 // has a default implementation (default impl throws with no context)
 DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, throwDeserializerException_msg, void(const Deserializer&, const std::string&));
@@ -5,9 +5,13 @@
 #include "API.h"
 #include <dynamix/object.hpp>
 #include <dynamix/object_of.hpp>
+#include <string_view>
+#include <memory_resource>
 
 namespace huse {
 class DeserializerNode;
+class DeserializerResult;
+class JsonPointer;
 class HUSE_API Deserializer : public dynamix::object {
 public:
     Deserializer();
@@ -16,12 +20,36 @@ public:
     DeserializerNode node();
     DeserializerNode root();
 
+    // the node of the value at a json pointer (RFC 6901)
+    // the backend navigates to it directly, without opening the nodes on the way
+    // the node behaves like the root until root() or at() is called again
+    DeserializerNode at(std::string_view pointer);
+    DeserializerNode at(const JsonPointer& pointer);
+
+    // read the root into v and return the result instead of throwing
+    // exceptions from user code are caught and reported as ErrorCode::User
+    template <typename T>
+    DeserializerResult tryVal(T& v);
+
+    // memory for the std::pmr values which are constructed while reading and don't get a
+    // resource from their container (see helpers/StdPmr.hpp)
+    // existing values are never moved to it
+    // it must outlive the values
+    // null (the default) means std::pmr::get_default_resource()
+    void setMemoryResource(std::pmr::memory_resource* r) { m_memoryResource = r; }
+    std::pmr::memory_resource* memoryResource() const {
+        return m_memoryResource ? m_memoryResource : std::pmr::get_default_resource();
+    }
+
     static Deserializer* of(void* mixin) {
         return static_cast<Deserializer*>(dynamix::object_of(mixin));
     }
     static const Deserializer* of(const void* mixin) {
         return static_cast<const Deserializer*>(dynamix::object_of(mixin));
     }
+
+private:
+    std::pmr::memory_resource* m_memoryResource = nullptr;
 };
 
 #define huse_d_self ::huse::Deserializer::of(this)
@@ -0,0 +1,21 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+
+namespace huse
+{
+
+// classification of serialization and deserialization errors
+enum class ErrorCode : int
+{
+    None = 0,
+    Syntax,       // the input is malformed and can't be parsed
+    TypeMismatch, // the value is not of the requested type
+    OutOfRange,   // missing key, index, or value
+    NumberRange,  // number can't be represented by the target type or format
+    Unsupported,  // the operation is not supported by the backend
+    User,         // custom error from user code (throwException)
+};
+
+}
@@ -0,0 +1,71 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include "Exception.hpp"
+
+#include <sstream>
+
+namespace huse
+{
+
+DeserializerException::DeserializerException(const DeserializerException& other)
+    : Exception(other)
+    , m_keys(other.m_keys)
+    , m_path(other.m_path)
+    , m_what(std::atomic_load(&other.m_what))
+{}
+
+DeserializerException& DeserializerException::operator=(const DeserializerException& other)
+{
+    Exception::operator=(other);
+    m_keys = other.m_keys;
+    m_path = other.m_path;
+    std::atomic_store(&m_what, std::atomic_load(&other.m_what));
+    return *this;
+}
+
+void DeserializerException::appendPath(std::string_view key, size_t index)
+{
+    auto& e = m_path.emplace_back();
+    e.keyOffset = uint32_t(m_keys.size());
+    e.keyLength = uint32_t(key.size());
+    e.index = index;
+    m_keys.append(key);
+    std::atomic_store(&m_what, std::shared_ptr<const std::string>());
+}
+
+const char* DeserializerException::what() const noexcept
+{
+    if (m_path.empty()) return message();
+    auto cur = std::atomic_load(&m_what);
+    if (cur) return cur->c_str();
+
+    try
+    {
+        std::ostringstream sout;
+
+        sout << pathElement(0).key; // don't wrap root in quotes
+
+        for (size_t i = 1; i < m_path.size(); ++i)
+        {
+            auto e = pathElement(i);
+            sout << '.';
+            if (e.key.empty()) sout << '[' << e.index << ']';
+            else sout << '"' << e.key << '"';
+        }
+
+        sout << " : " << message();
+        auto formatted = std::make_shared<const std::string>(sout.str());
+
+        // if another thread was first, use its text, so that the returned pointer stays valid
+        if (!std::atomic_compare_exchange_strong(&m_what, &cur, formatted)) return cur->c_str();
+        return formatted->c_str();
+    }
+    catch (...)
+    {
+        // no memory to format
+        return message();
+    }
+}
+
+}
@@ -3,8 +3,14 @@
 //
 #pragma once
 #include "API.h"
+#include "ErrorCode.hpp"
 
+#include <memory>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
 
 namespace huse
 {
@@ -12,7 +18,21 @@ class HUSE_API Exception : public std::runtime_error
 {
 public:
     using std::runtime_error::runtime_error;
+
+    Exception(ErrorCode code, const std::string& msg)
+        : std::runtime_error(msg)
+        , m_code(code)
+    {}
+
     virtual ~Exception() = 0; // still need to export the vtable
+
+    ErrorCode code() const noexcept { return m_code; }
+
+    // the message without any context
+    const char* message() const noexcept { return std::runtime_error::what(); }
+
+private:
+    ErrorCode m_code = ErrorCode::User;
 };
 
 class HUSE_API SerializerException : public Exception
@@ -27,6 +47,48 @@ class HUSE_API DeserializerException : public Exception
 public:
     using Exception::Exception;
     ~DeserializerException();
+
+    // the formatted text is shared, as another thread may be formatting it
+    DeserializerException(const DeserializerException& other);
+    DeserializerException& operator=(const DeserializerException& other);
+
+    // an element of the path to the value which caused the exception
+    // the first element is the root
+    // the key is empty for array elements
+    struct PathElement
+    {
+        std::string_view key;
+        size_t index;
+    };
+
+    // keys are copied, so the exception can outlive the deserializer and its document
+    void appendPath(std::string_view key, size_t index);
+
+    size_t pathLength() const noexcept { return m_path.size(); }
+    PathElement pathElement(size_t i) const noexcept
+    {
+        auto& e = m_path[i];
+        return {std::string_view(m_keys).substr(e.keyOffset, e.keyLength), e.index};
+    }
+
+    // message with the path prepended (if there is one)
+    // formatted on the first call (it's safe to call it from multiple threads)
+    // if formatting fails, the message without the path is returned
+    virtual const char* what() const noexcept override;
+
+private:
+    // keys are packed into a single buffer, elements store offsets in it
+    std::string m_keys;
+    struct PackedElement
+    {
+        uint32_t keyOffset;
+        uint32_t keyLength;
+        size_t index;
+    };
+    std::vector<PackedElement> m_path;
+
+    // accessed atomically
+    mutable std::shared_ptr<const std::string> m_what;
 };
 
 }
@@ -0,0 +1,141 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include "FragmentCache.hpp"
+
+namespace huse
+{
+
+FragmentCache::FragmentCache(size_t maxBytes, size_t numStripes)
+    : m_maxStripeBytes(maxBytes / (numStripes ? numStripes : 1))
+{
+    if (numStripes == 0) numStripes = 1;
+    m_stripes.reserve(numStripes);
+    for (size_t i = 0; i < numStripes; ++i)
+    {
+        m_stripes.emplace_back(new Stripe);
+    }
+}
+
+FragmentCache::~FragmentCache() = default;
+
+uint64_t FragmentCache::newVersion()
+{
+    static std::atomic<uint64_t> last = {};
+    return last.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+size_t FragmentCache::KeyHash::operator()(const Key& key) const
+{
+    // low bits of addresses are mostly zero because of alignment
+    auto h = std::hash<const void*>{}(key.obj);
+    h ^= h >> 17;
+    return h ^ (key.type.hash_code() * 31);
+}
+
+FragmentCache::Stripe& FragmentCache::stripe(const Key& key)
+{
+    return *m_stripes[KeyHash{}(key) % m_stripes.size()];
+}
+
+FragmentCache::Fragment FragmentCache::find(const void* obj, std::type_index type, uint64_t version)
+{
+    Key key = {obj, type};
+    auto& s = stripe(key);
+    std::lock_guard lock(s.mutex);
+
+    auto f = s.map.find(key);
+    if (f == s.map.end() || f->second->version != version)
+    {
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+        return {};
+    }
+
+    // move to front
+    s.lru.splice(s.lru.begin(), s.lru, f->second);
+    m_hits.fetch_add(1, std::memory_order_relaxed);
+    return f->second->json;
+}
+
+FragmentCache::Fragment FragmentCache::insert(const void* obj, std::type_index type, uint64_t version, std::string json)
+{
+    auto fragment = std::make_shared<const std::string>(std::move(json));
+
+    Key key = {obj, type};
+    auto& s = stripe(key);
+    std::lock_guard lock(s.mutex);
+
+    auto f = s.map.find(key);
+    if (f != s.map.end())
+    {
+        auto& e = *f->second;
+        s.bytes -= e.json->size();
+        e.version = version;
+        e.json = fragment;
+        s.lru.splice(s.lru.begin(), s.lru, f->second);
+    }
+    else
+    {
+        s.lru.push_front({key, version, fragment});
+        s.map.emplace(key, s.lru.begin());
+    }
+    s.bytes += fragment->size();
+
+    evict(s);
+
+    // the returned fragment is valid even if it was evicted immediately
+    return fragment;
+}
+
+void FragmentCache::evict(Stripe& s)
+{
+    while (s.bytes > m_maxStripeBytes && !s.lru.empty())
+    {
+        auto& e = s.lru.back();
+        s.bytes -= e.json->size();
+        s.map.erase(e.key);
+        s.lru.pop_back();
+        m_evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void FragmentCache::erase(const void* obj, std::type_index type)
+{
+    Key key = {obj, type};
+    auto& s = stripe(key);
+    std::lock_guard lock(s.mutex);
+
+    auto f = s.map.find(key);
+    if (f == s.map.end()) return;
+    s.bytes -= f->second->json->size();
+    s.lru.erase(f->second);
+    s.map.erase(f);
+}
+
+void FragmentCache::clear()
+{
+    for (auto& s : m_stripes)
+    {
+        std::lock_guard lock(s->mutex);
+        s->lru.clear();
+        s->map.clear();
+        s->bytes = 0;
+    }
+}
+
+FragmentCache::Stats FragmentCache::stats() const
+{
+    Stats ret = {};
+    ret.hits = m_hits.load(std::memory_order_relaxed);
+    ret.misses = m_misses.load(std::memory_order_relaxed);
+    ret.evictions = m_evictions.load(std::memory_order_relaxed);
+    for (auto& s : m_stripes)
+    {
+        std::lock_guard lock(s->mutex);
+        ret.entries += s->map.size();
+        ret.bytes += s->bytes;
+    }
+    return ret;
+}
+
+}
@@ -0,0 +1,149 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "API.h"
+#include "Serializer.hpp"
+#include "json/Serializer.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+namespace huse
+{
+
+namespace impl
+{
+template <typename, typename = void>
+struct HasVersionMethod : std::false_type {};
+template <typename T>
+struct HasVersionMethod<T, std::enable_if_t<std::is_convertible_v<decltype(std::declval<const T&>().huseVersion()), uint64_t>>> : std::true_type {};
+} // namespace impl
+
+// memoizes the serialized json of objects
+//
+// types opt in with `uint64_t huseVersion() const`
+// versions must be unique across all objects: take them from FragmentCache::newVersion when
+// the object is created and whenever its serialized data changes
+// objects are identified by address and type (so an object and its first member are different
+// entries) and a destroyed object may be replaced by another one at the same address, but the
+// new object has a different version, so the old entry is never returned for it
+// (erasing the entries of destroyed objects only frees their memory earlier)
+//
+//   struct Item {
+//       uint64_t version = huse::FragmentCache::newVersion();
+//       uint64_t huseVersion() const { return version; }
+//       void setPrice(int p) { price = p; version = huse::FragmentCache::newVersion(); }
+//       ...
+//   };
+//
+// only json is cached: it's written with SerializerNode::raw, so serializers which produce
+// json copy it verbatim and others (like the dom one) parse it
+//
+// entries are kept in a bounded LRU split in independently locked stripes, so the cache can
+// be shared between threads
+class HUSE_API FragmentCache
+{
+public:
+    explicit FragmentCache(size_t maxBytes = 64 * 1024 * 1024, size_t numStripes = 16);
+    ~FragmentCache();
+
+    FragmentCache(const FragmentCache&) = delete;
+    FragmentCache& operator=(const FragmentCache&) = delete;
+
+    using Fragment = std::shared_ptr<const std::string>;
+
+    // null if there is no entry for this object and version
+    Fragment find(const void* obj, std::type_index type, uint64_t version);
+
+    // replaces the entry for the object if there is one
+    Fragment insert(const void* obj, std::type_index type, uint64_t version, std::string json);
+
+    void erase(const void* obj, std::type_index type);
+    void clear();
+
+    template <typename T>
+    void erase(const T* obj) { erase(obj, typeid(T)); }
+
+    // a version which was never returned before (thread safe, never zero)
+    static uint64_t newVersion();
+
+    struct Stats
+    {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        size_t entries;
+        size_t bytes;
+    };
+    Stats stats() const;
+
+    // write the object to the node, serializing it only if needed
+    template <typename T>
+    void val(SerializerNode& n, const T& obj)
+    {
+        static_assert(impl::HasVersionMethod<T>::value, "cached types must have `uint64_t huseVersion() const` which returns a value from FragmentCache::newVersion()");
+
+        auto version = obj.huseVersion();
+        auto fragment = find(&obj, typeid(T), version);
+        if (!fragment)
+        {
+            std::ostringstream sout;
+            {
+                auto s = json::Make_Serializer(sout);
+                s.node().val(obj);
+            }
+            fragment = insert(&obj, typeid(T), version, sout.str());
+        }
+        n.raw(*fragment);
+    }
+
+private:
+    struct Key
+    {
+        const void* obj;
+        std::type_index type;
+        bool operator==(const Key& other) const { return obj == other.obj && type == other.type; }
+    };
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry
+    {
+        Key key;
+        uint64_t version;
+        Fragment json;
+    };
+
+    struct Stripe
+    {
+        std::mutex mutex;
+        std::list<Entry> lru; // most recently used first
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> map;
+        size_t bytes = 0;
+    };
+
+    Stripe& stripe(const Key& key);
+    void evict(Stripe& s);
+
+    const size_t m_maxStripeBytes;
+    std::vector<std::unique_ptr<Stripe>> m_stripes;
+
+    std::atomic<uint64_t> m_hits = {};
+    std::atomic<uint64_t> m_misses = {};
+    std::atomic<uint64_t> m_evictions = {};
+};
+
+}
@@ -0,0 +1,183 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include "HashStream.hpp"
+
+#include <cstring>
+
+namespace huse
+{
+
+namespace
+{
+// https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+constexpr uint64_t P1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t P3 = 0x165667B19E3779F9ull;
+constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t P5 = 0x27D4EB2F165667C5ull;
+
+constexpr uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+// the hash is defined on little endian words
+// compilers turn this into a single load on little endian platforms
+inline uint64_t read64(const char* p)
+{
+    uint8_t b[8];
+    std::memcpy(b, p, 8);
+    return uint64_t(b[0]) | uint64_t(b[1]) << 8 | uint64_t(b[2]) << 16 | uint64_t(b[3]) << 24
+        | uint64_t(b[4]) << 32 | uint64_t(b[5]) << 40 | uint64_t(b[6]) << 48 | uint64_t(b[7]) << 56;
+}
+
+inline uint32_t read32(const char* p)
+{
+    uint8_t b[4];
+    std::memcpy(b, p, 4);
+    return uint32_t(b[0]) | uint32_t(b[1]) << 8 | uint32_t(b[2]) << 16 | uint32_t(b[3]) << 24;
+}
+
+inline uint64_t round(uint64_t acc, uint64_t input)
+{
+    acc += input * P2;
+    acc = rotl(acc, 31);
+    return acc * P1;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t val)
+{
+    acc ^= round(0, val);
+    return acc * P1 + P4;
+}
+
+constexpr size_t Stripe_Size = 32;
+}
+
+static_assert(HashStreambuf::Block_Size % Stripe_Size == 0);
+
+HashStreambuf::HashStreambuf(uint64_t seed)
+{
+    reset(seed);
+}
+
+void HashStreambuf::reset(uint64_t seed)
+{
+    m_seed = seed;
+    m_acc[0] = seed + P1 + P2;
+    m_acc[1] = seed + P2;
+    m_acc[2] = seed;
+    m_acc[3] = seed - P1;
+    m_total = 0;
+    setp(m_block, m_block + Block_Size);
+}
+
+void HashStreambuf::consumeStripes(const char* p, size_t size)
+{
+    auto acc = m_acc;
+    const auto end = p + size;
+    for (; p != end; p += Stripe_Size)
+    {
+        acc[0] = round(acc[0], read64(p));
+        acc[1] = round(acc[1], read64(p + 8));
+        acc[2] = round(acc[2], read64(p + 16));
+        acc[3] = round(acc[3], read64(p + 24));
+    }
+    m_total += size;
+}
+
+HashStreambuf::int_type HashStreambuf::overflow(int_type ch)
+{
+    // the block is full
+    consumeStripes(m_block, Block_Size);
+    setp(m_block, m_block + Block_Size);
+    if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+    return ch;
+}
+
+std::streamsize HashStreambuf::xsputn(const char_type* s, std::streamsize num)
+{
+    auto size = size_t(num);
+    auto free = size_t(epptr() - pptr());
+    if (size < free)
+    {
+        std::memcpy(pptr(), s, size);
+        pbump(int(size));
+        return num;
+    }
+
+    // fill and consume the block
+    std::memcpy(pptr(), s, free);
+    consumeStripes(m_block, Block_Size);
+    s += free;
+    size -= free;
+
+    // consume whole stripes directly from the input
+    auto direct = size - size % Stripe_Size;
+    consumeStripes(s, direct);
+    s += direct;
+    size -= direct;
+
+    setp(m_block, m_block + Block_Size);
+    std::memcpy(m_block, s, size);
+    pbump(int(size));
+    return num;
+}
+
+uint64_t HashStreambuf::digest() const
+{
+    const char* p = pbase();
+    const char* const end = pptr();
+
+    // the staged bytes may contain whole stripes which are not consumed yet
+    uint64_t acc[4] = {m_acc[0], m_acc[1], m_acc[2], m_acc[3]};
+    uint64_t total = m_total;
+    for (; end - p >= ptrdiff_t(Stripe_Size); p += Stripe_Size)
+    {
+        acc[0] = round(acc[0], read64(p));
+        acc[1] = round(acc[1], read64(p + 8));
+        acc[2] = round(acc[2], read64(p + 16));
+        acc[3] = round(acc[3], read64(p + 24));
+        total += Stripe_Size;
+    }
+
+    uint64_t h;
+    if (total)
+    {
+        h = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) + rotl(acc[3], 18);
+        for (auto a : acc) h = mergeRound(h, a);
+    }
+    else
+    {
+        h = m_seed + P5;
+    }
+
+    total += uint64_t(end - p);
+    h += total;
+
+    for (; end - p >= 8; p += 8)
+    {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * P1 + P4;
+    }
+    if (end - p >= 4)
+    {
+        h ^= uint64_t(read32(p)) * P1;
+        h = rotl(h, 23) * P2 + P3;
+        p += 4;
+    }
+    for (; p != end; ++p)
+    {
+        h ^= uint64_t(uint8_t(*p)) * P5;
+        h = rotl(h, 11) * P1;
+    }
+
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h;
+}
+
+}
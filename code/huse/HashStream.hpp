@@ -0,0 +1,78 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "API.h"
+#include "Serializer.hpp"
+#include "json/Serializer.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+
+namespace huse
+{
+
+// a streambuf which hashes everything written to it with XXH64
+// the bytes are consumed as they come in, so nothing is kept apart from a single block
+//
+// use it as the output of a serializer to hash the serialized form of objects without
+// materializing it:
+//   huse::HashStreambuf hash;
+//   std::ostream out(&hash);
+//   {
+//       auto s = huse::json::Make_Serializer(out);
+//       s.root().val(obj);
+//   }
+//   auto digest = hash.digest();
+//
+// the digest is the same as the one of xxhash's XXH64 for the same bytes and seed
+class HUSE_API HashStreambuf : public std::streambuf
+{
+public:
+    explicit HashStreambuf(uint64_t seed = 0);
+
+    // hash of the bytes written so far
+    // more bytes can be written after that
+    uint64_t digest() const;
+
+    // number of bytes written so far
+    uint64_t size() const { return m_total + uint64_t(pptr() - pbase()); }
+
+    // start over
+    void reset(uint64_t seed = 0);
+
+    static constexpr size_t Block_Size = 256; // must be a multiple of the stripe size (32)
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char_type* s, std::streamsize num) override;
+
+private:
+    // consume a multiple of 32 bytes
+    void consumeStripes(const char* p, size_t size);
+
+    uint64_t m_seed;
+    uint64_t m_acc[4];
+    uint64_t m_total; // bytes in consumed stripes
+    char m_block[Block_Size];
+};
+
+// hash of the json which the object serializes to
+// with canonical the hash doesn't depend on the order in which members are written
+template <typename T>
+uint64_t contentHash(const T& obj, uint64_t seed = 0, bool canonical = false)
+{
+    HashStreambuf hash(seed);
+    std::ostream out(&hash);
+    {
+        json::SerializerOptions opts;
+        opts.canonical = canonical;
+        auto s = json::Make_Serializer(out, opts);
+        auto root = s.root();
+        root.val(obj);
+    }
+    return hash.digest();
+}
+
+}
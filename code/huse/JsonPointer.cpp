@@ -0,0 +1,60 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include "JsonPointer.hpp"
+#include "Exception.hpp"
+
+namespace huse
+{
+
+namespace
+{
+constexpr size_t npos = std::string_view::npos;
+
+// indices are not allowed to have leading zeroes
+size_t toIndex(std::string_view key)
+{
+    if (key.empty() || key.size() > 18) return npos;
+    if (key[0] == '0' && key.size() > 1) return npos;
+    size_t ret = 0;
+    for (auto c : key)
+    {
+        if (c < '0' || c > '9') return npos;
+        ret = ret * 10 + size_t(c - '0');
+    }
+    return ret;
+}
+}
+
+JsonPointer::JsonPointer(std::string_view text)
+    : m_text(text)
+{
+    if (text.empty()) return;
+    if (text[0] != '/') throw DeserializerException(ErrorCode::Syntax, "invalid json pointer: " + m_text);
+
+    while (!text.empty())
+    {
+        text.remove_prefix(1); // '/'
+        auto end = text.find('/');
+        auto raw = text.substr(0, end);
+        text = end == npos ? std::string_view{} : text.substr(end);
+
+        auto& seg = m_segments.emplace_back();
+        seg.key.reserve(raw.size());
+        for (size_t i = 0; i < raw.size(); ++i)
+        {
+            if (raw[i] != '~')
+            {
+                seg.key += raw[i];
+                continue;
+            }
+            ++i;
+            if (i < raw.size() && raw[i] == '0') seg.key += '~';
+            else if (i < raw.size() && raw[i] == '1') seg.key += '/';
+            else throw DeserializerException(ErrorCode::Syntax, "invalid escape in json pointer: " + m_text);
+        }
+        seg.index = toIndex(seg.key);
+    }
+}
+
+}
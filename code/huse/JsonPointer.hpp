@@ -0,0 +1,44 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "API.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace huse
+{
+
+// a parsed json pointer (RFC 6901)
+// parse once and reuse it for lookups in many documents
+class HUSE_API JsonPointer
+{
+public:
+    // points to the root
+    JsonPointer() = default;
+
+    // throws DeserializerException with ErrorCode::Syntax if the pointer is invalid
+    explicit JsonPointer(std::string_view text);
+
+    struct Segment
+    {
+        std::string key; // unescaped
+        size_t index; // key as an array index or npos if it isn't one
+    };
+
+    const std::string& text() const { return m_text; }
+
+    bool empty() const { return m_segments.empty(); }
+    size_t size() const { return m_segments.size(); }
+    const Segment& operator[](size_t i) const { return m_segments[i]; }
+    std::vector<Segment>::const_iterator begin() const { return m_segments.begin(); }
+    std::vector<Segment>::const_iterator end() const { return m_segments.end(); }
+
+private:
+    std::string m_text;
+    std::vector<Segment> m_segments;
+};
+
+}
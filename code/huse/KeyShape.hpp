@@ -0,0 +1,48 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace huse
+{
+
+// the learned key layout of objects which are read in the same place
+//
+// attach one to an object with DeserializerObject::shape and the object's key lookups
+// will first check the index at which the key of the same lookup was found last time
+// a lookup with a correct hint compares the key with a single key in the document (by length,
+// then by content) instead of searching for it
+// a wrong hint costs that comparison plus the regular search, after which the index is relearned
+// the shape only allocates when an object is read with more lookups than before
+//
+// a shape is not thread safe, so use one per call site and thread:
+//   thread_local huse::KeyShape shape;
+//   auto o = n.obj();
+//   o.shape(shape);
+class KeyShape
+{
+public:
+    static constexpr size_t Unknown = size_t(-1);
+
+    // the hint for the i-th key lookup in an object
+    // the deserializer checks the key at the hinted index, so the key of the lookup isn't stored
+    size_t& hint(size_t i)
+    {
+        if (i >= m_indices.size()) m_indices.resize(i + 1, Unknown);
+        return m_indices[i];
+    }
+
+    size_t size() const { return m_indices.size(); }
+
+    // the index of the key of the i-th lookup in the last object
+    size_t operator[](size_t i) const { return m_indices[i]; }
+
+    void clear() { m_indices.clear(); }
+
+private:
+    std::vector<size_t> m_indices;
+};
+
+}
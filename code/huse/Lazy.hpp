@@ -0,0 +1,108 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "Serializer.hpp"
+#include "Deserializer.hpp"
+#include "Transcode.hpp"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace huse
+{
+
+// a value whose deserialization is deferred until it's accessed
+//
+// deserializing a Lazy only stores a handle to the value in the parsed document
+// (see DeserializerNode::detach), which keeps the document alive until the value is loaded
+// get() deserializes the value on first access with a new deserializer, without parsing again
+// serializing a Lazy which was never accessed writes the original json verbatim if the
+// deserializer retained its source (a copy of it is kept) and transcodes the value otherwise
+//
+// with mutable json input and with the dom, the user owns the document, so it must outlive
+// the Lazy (like with Borrowed)
+// loading modifies the Lazy even through const access, so a Lazy which isn't loaded must not be
+// accessed from several threads at once; call get() before sharing it
+template <typename T>
+class Lazy
+{
+public:
+    Lazy() = default;
+    Lazy(T value) : m_value(std::move(value)) {}
+
+    Lazy& operator=(T value)
+    {
+        m_value = std::move(value);
+        m_detached = {};
+        m_json.clear();
+        return *this;
+    }
+
+    bool loaded() const { return !!m_value; }
+
+    // the original json of a value which hasn't been deserialized yet
+    // empty if loaded or if the source wasn't retained
+    std::string_view json() const { return m_json; }
+
+    // may throw DeserializerException
+    T& get()
+    {
+        load();
+        return *m_value;
+    }
+
+    const T& get() const
+    {
+        load();
+        return *m_value;
+    }
+
+    T& operator*() { return get(); }
+    const T& operator*() const { return get(); }
+    T* operator->() { return &get(); }
+    const T* operator->() const { return &get(); }
+
+    void huseSerialize(SerializerNode& n) const
+    {
+        if (m_value || !m_detached) n.val(get());
+        else if (!m_json.empty()) n.raw(m_json);
+        else
+        {
+            auto d = m_detached.deserializer();
+            auto in = d.root();
+            transcode(in, n);
+        }
+    }
+
+    void huseDeserialize(DeserializerNode& n)
+    {
+        m_value.reset();
+        m_detached = n.detach();
+        m_json = m_detached.source();
+    }
+
+private:
+    void load() const
+    {
+        if (m_value) return;
+        T value{};
+        if (m_detached)
+        {
+            auto d = m_detached.deserializer();
+            d.root().val(value);
+        }
+        m_value.emplace(std::move(value));
+        m_detached = {};
+        m_json.clear();
+        m_json.shrink_to_fit();
+    }
+
+    mutable std::optional<T> m_value;
+    mutable DetachedValue m_detached;
+    mutable std::string m_json;
+};
+
+}
@@ -86,6 +86,14 @@ public:
         return SerializerSStream(m_serializer, this);
     }
 
+    // write an already serialized json value verbatim
+    // the dom parses it and writes the value, other backends which don't produce json may throw
+    // in debug builds the json serializer validates it (see HUSE_VALIDATE_RAW_JSON)
+    void raw(std::string_view json)
+    {
+        writeRawJson_msg::call(m_serializer, json);
+    }
+
     [[noreturn]] void throwException(const std::string& msg) const;
 };
 
@@ -157,6 +165,11 @@ public:
     {
         return key(k).sstream();
     }
+
+    void raw(std::string_view k, std::string_view json)
+    {
+        key(k).raw(json);
+    }
 };
 
 inline SerializerSStream::SerializerSStream(Serializer& s, impl::UniqueStack* parent)
@@ -31,6 +31,16 @@ DYNAMIX_DEFINE_SIMPLE_MSG_EX(closeObject_msg, unicast, false, nullptr);
 DYNAMIX_DEFINE_SIMPLE_MSG_EX(openArray_msg, unicast, false, nullptr);
 DYNAMIX_DEFINE_SIMPLE_MSG_EX(closeArray_msg, unicast, false, nullptr);
 
+bool acceptsRawJsonDefault(const Serializer&) {
+    return false;
+}
+DYNAMIX_DEFINE_SIMPLE_MSG_EX(acceptsRawJson_msg, unicast, true, acceptsRawJsonDefault);
+
+void writeRawJsonDefault(Serializer&, std::string_view) {
+    throw SerializerException(ErrorCode::Unsupported, "raw json is not supported");
+}
+DYNAMIX_DEFINE_SIMPLE_MSG_EX(writeRawJson_msg, unicast, true, writeRawJsonDefault);
+
 void throwSerializerExceptionDefault(const Serializer&, const std::string& msg) {
     throw SerializerException(msg);
 }
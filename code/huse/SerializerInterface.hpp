@@ -41,6 +41,14 @@ DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, closeObject_msg, void(Serializer&)
 DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, openArray_msg, void(Serializer&));
 DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, closeArray_msg, void(Serializer&));
 
+// raw json
+// backends which produce json can write already serialized fragments verbatim
+// has a default implementation (default impl returns false)
+DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, acceptsRawJson_msg, bool(const Serializer&));
+// has a default implementation (default impl throws Unsupported)
+// backends which don't produce json can parse it with json::transcode
+DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, writeRawJson_msg, void(Serializer&, std::string_view json));
+
 // optional override
 // has a default implementation
 DYNAMIX_DECLARE_EXPORTED_SIMPLE_MSG(HUSE_API, throwSerializerException_msg, void(const Serializer&, const std::string&));
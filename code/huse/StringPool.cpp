@@ -0,0 +1,125 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include "StringPool.hpp"
+
+#include <cstring>
+#include <mutex>
+
+namespace huse
+{
+
+StringPool::StringPool(size_t numStripes)
+{
+    if (numStripes == 0) numStripes = 1;
+    m_stripes.reserve(numStripes);
+    for (size_t i = 0; i < numStripes; ++i)
+    {
+        m_stripes.emplace_back(new Stripe);
+    }
+}
+
+StringPool::~StringPool() = default;
+
+StringPool& StringPool::global()
+{
+    static StringPool pool;
+    return pool;
+}
+
+StringPool::Stripe& StringPool::stripe(size_t hash) const
+{
+    // the low bits select the bucket in the stripe's set, so use the high ones
+    return *m_stripes[(hash >> (sizeof(size_t) * 4)) % m_stripes.size()];
+}
+
+std::string_view StringPool::Stripe::store(std::string_view str)
+{
+    bytes += str.size();
+
+    if (str.size() > Block_Size / 2)
+    {
+        // big strings get their own block, so as not to waste the current one
+        blocks.emplace_back(new char[str.size()]);
+        allocatedBytes += str.size();
+        std::memcpy(blocks.back().get(), str.data(), str.size());
+        return {blocks.back().get(), str.size()};
+    }
+
+    if (str.size() > freeSize)
+    {
+        blocks.emplace_back(new char[Block_Size]);
+        allocatedBytes += Block_Size;
+        free = blocks.back().get();
+        freeSize = Block_Size;
+    }
+
+    auto ret = free;
+    std::memcpy(ret, str.data(), str.size());
+    free += str.size();
+    freeSize -= str.size();
+    return {ret, str.size()};
+}
+
+InternedString StringPool::find(std::string_view str) const
+{
+    if (str.empty()) return {};
+
+    auto& s = stripe(std::hash<std::string_view>{}(str));
+    std::shared_lock lock(s.mutex);
+    auto f = s.set.find(str);
+    if (f == s.set.end()) return {};
+    m_hits.fetch_add(1, std::memory_order_relaxed);
+    return InternedString(&*f);
+}
+
+InternedString StringPool::intern(std::string_view str)
+{
+    if (str.empty()) return {};
+
+    auto& s = stripe(std::hash<std::string_view>{}(str));
+
+    {
+        std::shared_lock lock(s.mutex);
+        auto f = s.set.find(str);
+        if (f != s.set.end())
+        {
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            return InternedString(&*f);
+        }
+    }
+
+    std::unique_lock lock(s.mutex);
+
+    // another thread may have added it in the meantime
+    auto f = s.set.find(str);
+    if (f != s.set.end())
+    {
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+        return InternedString(&*f);
+    }
+
+    auto stored = s.set.insert(s.store(str)).first;
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return InternedString(&*stored);
+}
+
+StringPool::Stats StringPool::stats() const
+{
+    Stats ret = {};
+    ret.hits = m_hits.load(std::memory_order_relaxed);
+    ret.misses = m_misses.load(std::memory_order_relaxed);
+    for (auto& s : m_stripes)
+    {
+        std::shared_lock lock(s->mutex);
+        ret.strings += s->set.size();
+        ret.bytes += s->bytes;
+        ret.allocatedBytes += s->allocatedBytes
+            + s->set.bucket_count() * sizeof(void*)
+            // nodes: a string_view, a next pointer, and (in most implementations) a cached hash
+            + s->set.size() * (sizeof(std::string_view) + 2 * sizeof(void*));
+    }
+    return ret;
+}
+
+}
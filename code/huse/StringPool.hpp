@@ -0,0 +1,151 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "API.h"
+#include "Serializer.hpp"
+#include "Deserializer.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace huse
+{
+
+// a handle to a string in a StringPool
+// handles of equal strings from the same pool are equal, so comparing them is a pointer
+// comparison
+// the default (null) handle is the empty string, which is never stored in a pool
+// handles are valid for as long as their pool
+class InternedString
+{
+public:
+    InternedString() = default;
+
+    std::string_view str() const { return m_str ? *m_str : std::string_view{}; }
+    operator std::string_view() const { return str(); }
+    bool empty() const { return !m_str; }
+
+    bool operator==(const InternedString& other) const { return m_str == other.m_str; }
+    bool operator!=(const InternedString& other) const { return m_str != other.m_str; }
+
+    // for hash tables of handles
+    const void* id() const { return m_str; }
+
+private:
+    friend class StringPool;
+    explicit InternedString(const std::string_view* str) : m_str(str) {}
+    const std::string_view* m_str = nullptr;
+};
+
+// an intern table for strings which repeat a lot (enum-like values, codes, names)
+// interning a string which is already in the pool is a hash lookup and doesn't allocate
+//
+// strings are never removed: the pool only grows until it's destroyed
+// the pool is split in independently locked stripes, so it can be shared between threads
+// lookups only take a shared lock
+class HUSE_API StringPool
+{
+public:
+    explicit StringPool(size_t numStripes = 16);
+    ~StringPool();
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    InternedString intern(std::string_view str);
+
+    // null if the string is not in the pool (never adds it)
+    InternedString find(std::string_view str) const;
+
+    struct Stats
+    {
+        uint64_t hits;
+        uint64_t misses; // strings which were added
+        size_t strings;
+        size_t bytes; // size of the stored strings
+        size_t allocatedBytes; // memory taken by the pool (an estimate for the hash tables)
+    };
+    Stats stats() const;
+
+    // a process-wide pool used by the default overloads for InternedString
+    static StringPool& global();
+
+    static constexpr size_t Block_Size = 4096;
+
+private:
+    struct Stripe
+    {
+        mutable std::shared_mutex mutex;
+
+        // node-based, so elements don't move and handles can point to them
+        std::unordered_set<std::string_view> set;
+
+        // storage for the characters
+        std::vector<std::unique_ptr<char[]>> blocks;
+        char* free = nullptr;
+        size_t freeSize = 0;
+
+        size_t bytes = 0;
+        size_t allocatedBytes = 0;
+
+        std::string_view store(std::string_view str);
+    };
+
+    Stripe& stripe(size_t hash) const;
+
+    std::vector<std::unique_ptr<Stripe>> m_stripes;
+
+    mutable std::atomic<uint64_t> m_hits = {};
+    std::atomic<uint64_t> m_misses = {};
+};
+
+// a serialization functor for InternedString with a given pool
+//   obj.cval("status", s.status, huse::Interned{pool});
+struct Interned
+{
+    StringPool& pool;
+
+    void operator()(SerializerNode& n, const InternedString& str) const
+    {
+        n.val(str.str());
+    }
+
+    void operator()(DeserializerNode& n, InternedString& str) const
+    {
+        std::string_view sv;
+        n.val(sv);
+        str = pool.intern(sv);
+    }
+};
+
+// the default overloads use the global pool
+inline void huseSerialize(SerializerNode& n, const InternedString& str)
+{
+    Interned{StringPool::global()}(n, str);
+}
+
+inline void huseDeserialize(DeserializerNode& n, InternedString& str)
+{
+    Interned{StringPool::global()}(n, str);
+}
+
+}
+
+namespace std
+{
+template <>
+struct hash<huse::InternedString>
+{
+    size_t operator()(const huse::InternedString& str) const noexcept
+    {
+        return hash<const void*>{}(str.id());
+    }
+};
+}
@@ -0,0 +1,103 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include "Transcode.hpp"
+#include "Serializer.hpp"
+#include "Deserializer.hpp"
+
+namespace huse
+{
+
+namespace
+{
+class Transcoder
+{
+public:
+    Transcoder(Deserializer& d, Serializer& s)
+        : m_raw(hasRawJson_msg::call(d) && acceptsRawJson_msg::call(s))
+    {}
+
+    void node(DeserializerNode& in, SerializerNode& out)
+    {
+        // a non-throwing deserializer reports null values after an error
+        if (failed(in)) return;
+
+        auto t = in.type();
+        if (t.is(Type::Object))
+        {
+            auto iobj = in.obj();
+            auto oobj = out.obj();
+            while (auto q = iobj.peeknext())
+            {
+                node(*q.node, oobj.key(q.name));
+            }
+        }
+        else if (t.is(Type::Array))
+        {
+            auto iar = in.ar();
+            auto oar = out.ar();
+            while (auto q = iar.peeknext())
+            {
+                node(*q.node, oar);
+            }
+        }
+        else if (m_raw)
+        {
+            auto raw = loadRawJson_msg::call(in._s());
+            // and an empty string on error
+            if (failed(in)) return;
+            writeRawJson_msg::call(out._s(), raw);
+        }
+        else if (t.is(Type::Null))
+        {
+            in.skip();
+            out.val(nullptr);
+        }
+        else if (t.is(Type::Boolean))
+        {
+            scalar<bool>(in, out);
+        }
+        else if (t.is(Type::UnsignedInteger))
+        {
+            scalar<unsigned long long>(in, out);
+        }
+        else if (t.is(Type::Integer))
+        {
+            scalar<long long>(in, out);
+        }
+        else if (t.is(Type::Float))
+        {
+            scalar<double>(in, out);
+        }
+        else
+        {
+            scalar<std::string_view>(in, out);
+        }
+    }
+
+private:
+    static bool failed(DeserializerNode& in)
+    {
+        return errorCode_msg::call(in._s()) != ErrorCode::None;
+    }
+
+    template <typename T>
+    static void scalar(DeserializerNode& in, SerializerNode& out)
+    {
+        T val = {};
+        in.val(val);
+        if (failed(in)) return;
+        out.val(val);
+    }
+
+    const bool m_raw;
+};
+}
+
+void transcode(DeserializerNode& in, SerializerNode& out)
+{
+    Transcoder t(in._s(), out._s());
+    t.node(in, out);
+}
+
+}
@@ -0,0 +1,21 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "API.h"
+#include "Fwd.hpp"
+
+namespace huse
+{
+
+// read the value from a deserializer node and write it to a serializer node
+// without going through C++ objects
+// works with any backends
+// if the input is json with a retained source and the output is json, numbers and strings
+// are copied verbatim without parsing, unescaping, formatting, or escaping
+// the generic path reads integers as long long, or as unsigned long long if the backend reports
+// Type::UnsignedInteger (integers which don't fit long long)
+// with a non-throwing deserializer, nothing is written for values after an error
+HUSE_API void transcode(DeserializerNode& in, SerializerNode& out);
+
+}
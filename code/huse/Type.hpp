@@ -13,9 +13,11 @@ public:
         True = 0b01,
         False = 0b10,
         Boolean = 0b11,
-        Integer = 0b0100,
+        SignedInteger = 0b0100,
+        UnsignedInteger = 0b100000000, // only for values which don't fit a signed integer
+        Integer = 0b100000100,
         Float = 0b1000,
-        Number = 0b1100,
+        Number = 0b100001100,
         String = 0b10000,
         Object = 0b100000,
         Array = 0b1000000,
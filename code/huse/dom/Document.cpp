@@ -0,0 +1,63 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include "Document.hpp"
+
+namespace huse::dom
+{
+
+namespace
+{
+constexpr size_t Max_Block_Size = 1024 * 1024;
+}
+
+void* Arena::allocate(size_t size, size_t alignment)
+{
+    if (size == 0) return nullptr;
+
+    auto alignedCur = [&]() {
+        auto p = reinterpret_cast<uintptr_t>(m_cur);
+        p = (p + alignment - 1) & ~uintptr_t(alignment - 1);
+        return reinterpret_cast<std::byte*>(p);
+    };
+
+    if (m_cur)
+    {
+        auto p = alignedCur();
+        if (p + size <= m_end)
+        {
+            m_cur = p + size;
+            return p;
+        }
+    }
+
+    // doesn't fit in the current block
+    auto needed = size + alignment;
+    if (needed > m_nextBlockSize)
+    {
+        // dedicated block for big allocations
+        // the current block stays current, so its remaining space can still be used
+        auto& block = m_blocks.emplace_back(new std::byte[needed]);
+        auto p = reinterpret_cast<uintptr_t>(block.get());
+        p = (p + alignment - 1) & ~uintptr_t(alignment - 1);
+        return reinterpret_cast<void*>(p);
+    }
+
+    auto& block = m_blocks.emplace_back(new std::byte[m_nextBlockSize]);
+    m_cur = block.get();
+    m_end = m_cur + m_nextBlockSize;
+    if (m_nextBlockSize < Max_Block_Size) m_nextBlockSize *= 2;
+
+    auto p = alignedCur();
+    m_cur = p + size;
+    return p;
+}
+
+void Arena::clear()
+{
+    m_blocks.clear();
+    m_cur = m_end = nullptr;
+    m_nextBlockSize = Initial_Block_Size;
+}
+
+}
@@ -0,0 +1,341 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "../API.h"
+#include "../impl/Assert.hpp"
+#include "../Exception.hpp"
+
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <utility>
+
+namespace huse::dom
+{
+
+// bump allocator for the nodes and strings of a document
+// memory is only freed when the arena is cleared or destroyed
+class HUSE_API Arena
+{
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    // the moved-from arena is empty, so it doesn't allocate in blocks which it no longer owns
+    Arena(Arena&& other) noexcept
+        : m_blocks(std::move(other.m_blocks))
+        , m_cur(std::exchange(other.m_cur, nullptr))
+        , m_end(std::exchange(other.m_end, nullptr))
+        , m_nextBlockSize(std::exchange(other.m_nextBlockSize, Initial_Block_Size))
+    {
+        other.m_blocks.clear();
+    }
+    Arena& operator=(Arena&& other) noexcept
+    {
+        if (this == &other) return *this;
+        m_blocks = std::move(other.m_blocks);
+        other.m_blocks.clear();
+        m_cur = std::exchange(other.m_cur, nullptr);
+        m_end = std::exchange(other.m_end, nullptr);
+        m_nextBlockSize = std::exchange(other.m_nextBlockSize, Initial_Block_Size);
+        return *this;
+    }
+
+    static constexpr size_t Initial_Block_Size = 4096;
+
+    void* allocate(size_t size, size_t alignment);
+
+    template <typename T>
+    T* allocateArray(size_t n)
+    {
+        return static_cast<T*>(allocate(sizeof(T) * n, alignof(T)));
+    }
+
+    void clear();
+
+private:
+    std::vector<std::unique_ptr<std::byte[]>> m_blocks;
+    std::byte* m_cur = nullptr;
+    std::byte* m_end = nullptr;
+    size_t m_nextBlockSize = Initial_Block_Size;
+};
+
+struct Member;
+
+// a node in the tree
+// trivially copyable, 16 bytes
+// strings up to Sso_Capacity bytes are stored inline, longer ones and compounds point inside an arena
+class Value
+{
+public:
+    enum class Kind : uint8_t
+    {
+        Null,
+        False,
+        True,
+        Integer, // int64_t
+        UInteger, // uint64_t, only used for values which don't fit in int64_t
+        Float, // double
+        String,
+        Array,
+        Object,
+    };
+
+    static constexpr size_t Sso_Capacity = 14;
+
+    // lengths of strings, arrays and objects are stored in 32 bits
+    // longer values throw ErrorCode::OutOfRange
+    static constexpr size_t Max_Length = UINT32_MAX;
+
+    Value() = default; // null
+
+    static Value null() { return {}; }
+
+    static Value boolean(bool b)
+    {
+        Value ret;
+        ret.m_kind = b ? Kind::True : Kind::False;
+        return ret;
+    }
+
+    static Value integer(int64_t i)
+    {
+        Value ret;
+        ret.m_kind = Kind::Integer;
+        ret.store(i);
+        return ret;
+    }
+
+    static Value uinteger(uint64_t u)
+    {
+        // keep integers canonical, so readers only check UInteger for big values
+        if (u <= uint64_t(INT64_MAX)) return integer(int64_t(u));
+        Value ret;
+        ret.m_kind = Kind::UInteger;
+        ret.store(u);
+        return ret;
+    }
+
+    static Value number(double d)
+    {
+        Value ret;
+        ret.m_kind = Kind::Float;
+        ret.store(d);
+        return ret;
+    }
+
+    // the string is copied (in the arena if it doesn't fit inline)
+    static Value string(std::string_view str, Arena& arena)
+    {
+        checkLength(str.size());
+        Value ret;
+        ret.m_kind = Kind::String;
+        if (str.size() <= Sso_Capacity)
+        {
+            std::memcpy(ret.m_data, str.data(), str.size());
+            ret.m_inlineLength = uint8_t(str.size());
+        }
+        else
+        {
+            auto buf = arena.allocateArray<char>(str.size());
+            std::memcpy(buf, str.data(), str.size());
+            ret.storeRef(static_cast<const char*>(buf), str.size());
+        }
+        return ret;
+    }
+
+    // the elements must be allocated in the same arena as the array
+    static Value array(const Value* elements, size_t size)
+    {
+        Value ret;
+        ret.m_kind = Kind::Array;
+        ret.storeRef(elements, size);
+        return ret;
+    }
+
+    // the members must be allocated in the same arena as the object
+    static Value object(const Member* members, size_t size)
+    {
+        Value ret;
+        ret.m_kind = Kind::Object;
+        ret.storeRef(members, size);
+        return ret;
+    }
+
+    Kind kind() const { return m_kind; }
+
+    bool isNull() const { return m_kind == Kind::Null; }
+    bool isBool() const { return m_kind == Kind::True || m_kind == Kind::False; }
+    bool isInteger() const { return m_kind == Kind::Integer || m_kind == Kind::UInteger; }
+    bool isNumber() const { return isInteger() || m_kind == Kind::Float; }
+    bool isString() const { return m_kind == Kind::String; }
+    bool isArray() const { return m_kind == Kind::Array; }
+    bool isObject() const { return m_kind == Kind::Object; }
+
+    bool asBool() const
+    {
+        HUSE_ASSERT_USAGE(isBool(), "not a boolean");
+        return m_kind == Kind::True;
+    }
+
+    int64_t asInt() const
+    {
+        HUSE_ASSERT_USAGE(m_kind == Kind::Integer, "not an int64");
+        return load<int64_t>();
+    }
+
+    uint64_t asUInt() const
+    {
+        HUSE_ASSERT_USAGE(m_kind == Kind::UInteger, "not a big uint64");
+        return load<uint64_t>();
+    }
+
+    double asDouble() const
+    {
+        HUSE_ASSERT_USAGE(m_kind == Kind::Float, "not a double");
+        return load<double>();
+    }
+
+    std::string_view asString() const
+    {
+        HUSE_ASSERT_USAGE(isString(), "not a string");
+        if (m_inlineLength != Not_Inline) return std::string_view(m_data, m_inlineLength);
+        return std::string_view(load<const char*>(), loadLength());
+    }
+
+    // number of elements or members
+    size_t size() const
+    {
+        HUSE_ASSERT_USAGE(isArray() || isObject(), "not a compound");
+        return loadLength();
+    }
+
+    const Value& element(size_t i) const
+    {
+        HUSE_ASSERT_USAGE(isArray(), "not an array");
+        HUSE_ASSERT_USAGE(i < size(), "index out of range");
+        return load<const Value*>()[i];
+    }
+
+    // defined below Member
+    const Member& member(size_t i) const;
+
+    // linear search
+    // return nullptr if there is no such key
+    const Value* find(std::string_view key) const;
+
+private:
+    static constexpr uint8_t Not_Inline = 0xFF;
+
+    template <typename T>
+    T load() const
+    {
+        T ret;
+        std::memcpy(&ret, m_data, sizeof(T));
+        return ret;
+    }
+
+    template <typename T>
+    void store(T t)
+    {
+        std::memcpy(m_data, &t, sizeof(T));
+    }
+
+    uint32_t loadLength() const
+    {
+        uint32_t ret;
+        std::memcpy(&ret, m_data + sizeof(void*), sizeof(uint32_t));
+        return ret;
+    }
+
+    static void checkLength(size_t length)
+    {
+        if (length > Max_Length) throw SerializerException(ErrorCode::OutOfRange, "dom values are limited to 4G elements");
+    }
+
+    template <typename T>
+    void storeRef(const T* ptr, size_t length)
+    {
+        checkLength(length);
+        store(ptr);
+        auto l32 = uint32_t(length);
+        std::memcpy(m_data + sizeof(void*), &l32, sizeof(uint32_t));
+        m_inlineLength = Not_Inline;
+    }
+
+    // payload: value or pointer followed by a 32-bit length, or an inline string
+    alignas(8) char m_data[Sso_Capacity] = {};
+    uint8_t m_inlineLength = 0;
+    Kind m_kind = Kind::Null;
+};
+
+static_assert(sizeof(Value) == 16);
+
+struct Member
+{
+    Value key; // always a string
+    Value value;
+};
+
+inline const Member& Value::member(size_t i) const
+{
+    HUSE_ASSERT_USAGE(isObject(), "not an object");
+    HUSE_ASSERT_USAGE(i < size(), "index out of range");
+    return load<const Member*>()[i];
+}
+
+inline const Value* Value::find(std::string_view key) const
+{
+    HUSE_ASSERT_USAGE(isObject(), "not an object");
+    auto members = load<const Member*>();
+    auto end = members + loadLength();
+    for (auto m = members; m != end; ++m)
+    {
+        if (m->key.asString() == key) return &m->value;
+    }
+    return nullptr;
+}
+
+// an owned tree of values
+// moving the document doesn't invalidate the values inside it
+class HUSE_API Document
+{
+public:
+    Document() = default;
+    Document(const Document&) = delete;
+    Document& operator=(const Document&) = delete;
+    // the moved-from document is empty
+    Document(Document&& other) noexcept
+        : m_arena(std::move(other.m_arena))
+        , m_root(std::exchange(other.m_root, Value{}))
+    {}
+    Document& operator=(Document&& other) noexcept
+    {
+        if (this == &other) return *this;
+        m_arena = std::move(other.m_arena);
+        m_root = std::exchange(other.m_root, Value{});
+        return *this;
+    }
+
+    const Value& root() const { return m_root; }
+    void setRoot(const Value& root) { m_root = root; }
+
+    Arena& arena() { return m_arena; }
+
+    // free all memory and set root to null
+    void clear()
+    {
+        m_arena.clear();
+        m_root = {};
+    }
+
+private:
+    Arena m_arena;
+    Value m_root;
+};
+
+}
@@ -0,0 +1,567 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include "DomDeserializer.hpp"
+#include "Document.hpp"
+
+#include "../DeserializerObj.hpp"
+#include "../DeserializerInterface.hpp"
+#include "../Domain.hpp"
+#include "../Exception.hpp"
+#include "../JsonPointer.hpp"
+#include "../PolyTraits.hpp"
+#include "../impl/Assert.hpp"
+
+#include <itlib/mem_streambuf.hpp>
+
+#include <dynamix/define_mixin.hpp>
+#include <dynamix/mutate.hpp>
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <istream>
+#include <limits>
+#include <type_traits>
+
+namespace huse::dom
+{
+
+namespace
+{
+constexpr std::string_view Not_Integer = "not an integer";
+constexpr std::string_view Out_of_Range = "out of range";
+constexpr std::string_view Negative_Integer = "negative integer";
+constexpr std::string_view Integer_Too_Big = "integer doesn't fit in target type";
+
+struct MemIStream
+{
+    MemIStream(std::string_view str)
+        : streambuf(str.data(), str.size())
+        , stream(&streambuf)
+    {}
+
+    itlib::mem_istreambuf<char> streambuf;
+    std::istream stream;
+};
+}
+
+struct DomDeserializer
+{
+    const Value& rootValue;
+
+    struct Item
+    {
+        const Value* value;
+        std::string_view key;
+        size_t index;
+    };
+
+    struct StackElement
+    {
+        Item item;
+        std::optional<Item> pending;
+    };
+    std::vector<StackElement> stack;
+    static constexpr size_t Initial_Stack_Capacity = 16;
+
+    Item current = {}; // only valid after advance
+
+    std::optional<MemIStream> m_stringStream;
+
+    // root set by a json pointer (see loadPointer)
+    std::optional<Item> m_pointerRoot;
+    std::string m_pointerText;
+
+    DomDeserializer(const Value& root)
+        : rootValue(root)
+    {
+        // so that reading typical documents doesn't allocate
+        stack.reserve(Initial_Stack_Capacity);
+    }
+
+    ~DomDeserializer() {
+        HUSE_ASSERT_INTERNAL(stack.size() == 0);
+    }
+
+    template <typename T>
+    void readInt(T& val)
+    {
+        using Limits = std::numeric_limits<T>;
+        auto& v = r();
+        switch (v.kind())
+        {
+        case Value::Kind::Integer: {
+            auto i = v.asInt();
+            if constexpr (std::is_unsigned_v<T>)
+            {
+                if (i < 0) throwException(ErrorCode::NumberRange, Negative_Integer);
+                if (uint64_t(i) > uint64_t(Limits::max())) throwException(ErrorCode::NumberRange, Integer_Too_Big);
+            }
+            else
+            {
+                if (i < int64_t(Limits::min()) || i > int64_t(Limits::max())) throwException(ErrorCode::NumberRange, Integer_Too_Big);
+            }
+            val = T(i);
+            return;
+        }
+        case Value::Kind::UInteger: {
+            auto u = v.asUInt();
+            if (u > uint64_t(Limits::max())) throwException(ErrorCode::NumberRange, Integer_Too_Big);
+            val = T(u);
+            return;
+        }
+        case Value::Kind::Float: {
+            // accept integral floats like the json deserializer does
+            auto d = v.asDouble();
+            double tmp;
+            if (!std::isfinite(d) || std::modf(d, &tmp) != 0) throwException(ErrorCode::TypeMismatch, Not_Integer);
+            if constexpr (std::is_unsigned_v<T>)
+            {
+                if (d < 0) throwException(ErrorCode::NumberRange, Negative_Integer);
+            }
+            // max + 1 is a power of two, so it's exact even when max isn't
+            if (d < double(Limits::min()) || d >= double(Limits::max() / 2 + 1) * 2) throwException(ErrorCode::NumberRange, Integer_Too_Big);
+            val = T(d);
+            return;
+        }
+        default:
+            throwException(ErrorCode::TypeMismatch, Not_Integer);
+        }
+    }
+
+    template <typename T>
+    void readFloat(T& val)
+    {
+        auto& v = r();
+        switch (v.kind())
+        {
+        case Value::Kind::Integer: val = T(v.asInt()); return;
+        case Value::Kind::UInteger: val = T(v.asUInt()); return;
+        case Value::Kind::Float: val = T(v.asDouble()); return;
+        default:
+            throwException(ErrorCode::TypeMismatch, "not a number");
+        }
+    }
+
+    template <typename S>
+    void readString(S& val)
+    {
+        auto& v = r();
+        if (!v.isString()) throwException(ErrorCode::TypeMismatch, "not a string");
+        auto str = v.asString();
+        // assign, so that strings reuse their capacity
+        if constexpr (std::is_same_v<S, std::string_view>) val = str;
+        else val.assign(str.data(), str.size());
+    }
+
+    void advance()
+    {
+        if (stack.empty())
+        {
+            current = root();
+            return;
+        }
+
+        auto& top = stack.back();
+        auto& compound = *top.item.value;
+        HUSE_ASSERT_INTERNAL(compound.isArray() || compound.isObject());
+
+        if (!top.pending)
+        {
+            // "hacky" adjust current so that the exception stack printer does something nice
+            current.key = {};
+            current.index = compound.size();
+            throwException(ErrorCode::OutOfRange, Out_of_Range);
+        }
+
+        current = *top.pending;
+        auto nextIndex = top.pending->index + 1;
+
+        if (compound.size() <= nextIndex)
+        {
+            top.pending.reset();
+            return;
+        }
+
+        setPending(top, nextIndex);
+    }
+
+    static void setPending(StackElement& top, size_t index)
+    {
+        auto& compound = *top.item.value;
+        auto& pending = top.pending.emplace();
+        if (compound.isArray())
+        {
+            pending.value = &compound.element(index);
+            pending.key = {};
+        }
+        else
+        {
+            auto& m = compound.member(index);
+            pending.value = &m.value;
+            pending.key = m.key.asString();
+        }
+        pending.index = index;
+    }
+
+    const Value& r()
+    {
+        advance();
+        return *current.value;
+    }
+
+    bool tryLoadKey(std::string_view key)
+    {
+        HUSE_ASSERT_INTERNAL(!stack.empty());
+
+        auto& top = stack.back();
+        auto& compound = *top.item.value;
+
+        HUSE_ASSERT_INTERNAL(compound.isObject());
+
+        // optimistic check whether the pending key is what we actually want
+        if (top.pending && top.pending->key == key) return true;
+
+        // linear search
+        // objects written by the dom serializer keep the order of their keys,
+        // so we start from the pending one, which is the most likely to match
+        auto size = compound.size();
+        size_t start = top.pending ? top.pending->index : 0;
+        for (size_t n = 0; n < size; ++n)
+        {
+            auto i = (start + n) % size;
+            if (compound.member(i).key.asString() == key)
+            {
+                setPending(top, i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool tryLoadKeyHinted(std::string_view key, size_t& hint)
+    {
+        HUSE_ASSERT_INTERNAL(!stack.empty());
+
+        auto& top = stack.back();
+        auto& compound = *top.item.value;
+
+        if (hint < compound.size() && compound.member(hint).key.asString() == key)
+        {
+            setPending(top, hint);
+            return true;
+        }
+
+        if (!tryLoadKey(key)) return false;
+        hint = top.pending->index;
+        return true;
+    }
+
+    Item root() const
+    {
+        if (m_pointerRoot) return *m_pointerRoot;
+        return {&rootValue, "root", 0};
+    }
+
+    void loadPointer(const JsonPointer& ptr)
+    {
+        m_pointerRoot.reset();
+        if (ptr.empty()) return;
+
+        HUSE_ASSERT_USAGE(stack.empty(), "json pointers can only be loaded from the root");
+
+        m_pointerText = ptr.text();
+
+        auto v = &rootValue;
+        size_t index = 0;
+        for (auto& seg : ptr)
+        {
+            index = std::string_view::npos;
+            if (v->isObject())
+            {
+                for (size_t i = 0; i < v->size(); ++i)
+                {
+                    if (v->member(i).key.asString() == seg.key)
+                    {
+                        index = i;
+                        break;
+                    }
+                }
+            }
+            else if (v->isArray() && seg.index < v->size())
+            {
+                index = seg.index;
+            }
+
+            if (index == std::string_view::npos)
+            {
+                // "hacky" adjust current so that the exception stack printer does something nice
+                current = {v, m_pointerText, 0};
+                throwException(ErrorCode::OutOfRange, Out_of_Range);
+            }
+
+            v = v->isObject() ? &v->member(index).value : &v->element(index);
+        }
+
+        m_pointerRoot = Item{v, m_pointerText, index};
+    }
+
+    // only the top frame changes while reading its elements
+    struct Bookmark
+    {
+        size_t depth;
+        const Value* compound; // identifies the top frame, null at the root
+        std::optional<Item> pending;
+        Item current;
+    };
+
+    const Value* topCompound() const
+    {
+        return stack.empty() ? nullptr : stack.back().item.value;
+    }
+
+    DeserializerBookmark bookmark() const
+    {
+        Bookmark bm = {stack.size(), topCompound(), {}, current};
+        if (!stack.empty()) bm.pending = stack.back().pending;
+        return {this, bm};
+    }
+
+    void restore(const DeserializerBookmark& b)
+    {
+        // a compound is identified by its address, so this also checks the ancestors
+        if (b.owner() != this
+            || b.state<Bookmark>().depth != stack.size()
+            || b.state<Bookmark>().compound != topCompound())
+        {
+            throwException(ErrorCode::OutOfRange, "bookmark of a different node");
+        }
+        auto& bm = b.state<Bookmark>();
+        if (!stack.empty()) stack.back().pending = bm.pending;
+        current = bm.current;
+    }
+
+    void loadKey(std::string_view key)
+    {
+        if (!tryLoadKey(key))
+        {
+            // "hacky" adjust current so that the exception stack printer does something nice
+            current.key = key;
+            throwException(ErrorCode::OutOfRange, Out_of_Range);
+        }
+    }
+
+    bool hasPending() const
+    {
+        if (stack.empty()) return true; // root is pending
+        return !!stack.back().pending;
+    }
+
+    std::string_view pendingKey()
+    {
+        auto t = optPendingKey();
+        if (t) return *t;
+        // "hacky" adjust current so that the exception stack printer does something nice
+        current.key = {};
+        current.index = stack.back().item.value->size();
+        throwException(ErrorCode::OutOfRange, Out_of_Range);
+    }
+
+    std::optional<std::string_view> optPendingKey() const
+    {
+        HUSE_ASSERT_INTERNAL(!stack.empty());
+        auto& top = stack.back();
+        HUSE_ASSERT_INTERNAL(top.item.value->isObject());
+        if (top.pending) return top.pending->key;
+        return std::nullopt;
+    }
+
+    void loadIndex(size_t index)
+    {
+        HUSE_ASSERT_INTERNAL(!stack.empty());
+
+        auto& top = stack.back();
+
+        HUSE_ASSERT_INTERNAL(top.item.value->isArray());
+
+        // optimistic check whether the pending index is the same
+        if (top.pending && top.pending->index == index) return;
+
+        if (index >= top.item.value->size()) {
+            // "hacky" adjust current so that the exception stack printer does something nice
+            current.key = {};
+            current.index = index;
+            throwException(ErrorCode::OutOfRange, Out_of_Range);
+        }
+
+        // adjust pending so the next call of advance loads it
+        setPending(top, index);
+    }
+
+    void loadCompound(Value::Kind target)
+    {
+        advance();
+        if (current.value->kind() != target)
+        {
+            if (target == Value::Kind::Array) throwException(ErrorCode::TypeMismatch, "not an array");
+            else throwException(ErrorCode::TypeMismatch, "not an object");
+        }
+
+        auto& top = stack.emplace_back();
+        top.item = current;
+
+        // adjust pending so the next call of advance loads it
+        if (current.value->size() == 0) return; // empty compound, nothing to do
+        setPending(top, 0);
+    }
+
+    void unloadCompound()
+    {
+        stack.pop_back();
+    }
+
+    size_t curLength() const
+    {
+        if (stack.empty()) return 1;
+        return stack.back().item.value->size();
+    }
+
+    static Type fromKind(Value::Kind k)
+    {
+        switch (k)
+        {
+        case Value::Kind::Integer:  return {Type::SignedInteger};
+        case Value::Kind::UInteger: return {Type::UnsignedInteger};
+        case Value::Kind::Float:    return {Type::Float};
+        case Value::Kind::Null:     return {Type::Null};
+        case Value::Kind::False:    return {Type::False};
+        case Value::Kind::True:     return {Type::True};
+        case Value::Kind::String:   return {Type::String};
+        case Value::Kind::Array:    return {Type::Array};
+        case Value::Kind::Object:   return {Type::Object};
+        default:
+            HUSE_ASSERT_INTERNAL(false);
+            return {Type::Null};
+        }
+    }
+
+    Type pendingType() const
+    {
+        if (stack.empty()) return fromKind(root().value->kind());
+
+        auto& top = stack.back();
+        HUSE_ASSERT_INTERNAL(top.pending);
+        return fromKind(top.pending->value->kind());
+    }
+
+    [[noreturn]] void throwException(ErrorCode code, const std::string_view msg) const
+    {
+        DeserializerException ex(code, std::string(msg));
+        for (auto& elem : stack)
+        {
+            ex.appendPath(elem.item.key, elem.item.index);
+        }
+        ex.appendPath(current.key, current.index);
+        throw ex;
+    }
+
+    std::istream& loadStringStream()
+    {
+        std::string_view cur;
+        readString(cur);
+        HUSE_ASSERT_INTERNAL(!m_stringStream);
+        m_stringStream.emplace(cur);
+        return m_stringStream->stream;
+    }
+
+    void unloadStringStream()
+    {
+        HUSE_ASSERT_INTERNAL(!!m_stringStream);
+        m_stringStream.reset();
+    }
+
+    void husePolyDeserialize(bool& val) {
+        auto& v = r();
+        if (!v.isBool()) throwException(ErrorCode::TypeMismatch, "not a boolean");
+        val = v.asBool();
+    }
+    void husePolyDeserialize(short& val) { readInt(val); }
+    void husePolyDeserialize(unsigned short& val) { readInt(val); }
+    void husePolyDeserialize(int& val) { readInt(val); }
+    void husePolyDeserialize(unsigned int& val) { readInt(val); }
+    void husePolyDeserialize(long& val) { readInt(val); }
+    void husePolyDeserialize(unsigned long& val) { readInt(val); }
+    void husePolyDeserialize(long long& val) { readInt(val); }
+    void husePolyDeserialize(unsigned long long& val) { readInt(val); }
+    void husePolyDeserialize(float& val) { readFloat(val); }
+    void husePolyDeserialize(double& val) { readFloat(val); }
+    void husePolyDeserialize(std::string_view& val) { readString(val); }
+    void husePolyDeserialize(std::string& val) { readString(val); }
+};
+
+namespace
+{
+Deserializer makeDetached(const DetachedValue& dv);
+}
+
+DYNAMIX_DEFINE_MIXIN(Domain, DomDeserializer)
+    .implements<husePolyDeserialize_bool>()
+    .implements<husePolyDeserialize_short>()
+    .implements<husePolyDeserialize_ushort>()
+    .implements<husePolyDeserialize_int>()
+    .implements<husePolyDeserialize_uint>()
+    .implements<husePolyDeserialize_long>()
+    .implements<husePolyDeserialize_ulong>()
+    .implements<husePolyDeserialize_llong>()
+    .implements<husePolyDeserialize_ullong>()
+    .implements<husePolyDeserialize_float>()
+    .implements<husePolyDeserialize_double>()
+    .implements<husePolyDeserialize_sv>()
+    .implements<husePolyDeserialize_string>()
+    .implements_by<skip_msg>([](DomDeserializer* d) { d->advance(); })
+    .implements_by<loadStringStream_msg>([](DomDeserializer* d) -> std::istream& { return d->loadStringStream(); })
+    .implements_by<unloadStringStream_msg>([](DomDeserializer* d) { d->unloadStringStream(); })
+    .implements_by<loadObject_msg>([](DomDeserializer* d) { d->loadCompound(Value::Kind::Object); })
+    .implements_by<unloadObject_msg>([](DomDeserializer* d) { d->unloadCompound(); })
+    .implements_by<loadArray_msg>([](DomDeserializer* d) { d->loadCompound(Value::Kind::Array); })
+    .implements_by<unloadArray_msg>([](DomDeserializer* d) { d->unloadCompound(); })
+    .implements_by<curLength_msg>([](const DomDeserializer* d) { return d->curLength(); })
+    .implements_by<loadKey_msg>([](DomDeserializer* d, std::string_view key) { d->loadKey(key); })
+    .implements_by<tryLoadKey_msg>([](DomDeserializer* d, std::string_view key) { return d->tryLoadKey(key); })
+    .implements_by<tryLoadKeyHinted_msg>([](DomDeserializer* d, std::string_view key, size_t& hint) { return d->tryLoadKeyHinted(key, hint); })
+    .implements_by<loadIndex_msg>([](DomDeserializer* d, size_t index) { d->loadIndex(index); })
+    .implements_by<hasPending_msg>([](const DomDeserializer* d) { return d->hasPending(); })
+    .implements_by<pendingType_msg>([](const DomDeserializer* d) { return d->pendingType(); })
+    .implements_by<pendingKey_msg>([](const DomDeserializer* d) { return const_cast<DomDeserializer*>(d)->pendingKey(); })
+    .implements_by<optPendingKey_msg>([](const DomDeserializer* d) { return d->optPendingKey(); })
+    .implements_by<loadPointer_msg>([](DomDeserializer* d, const JsonPointer& ptr) { d->loadPointer(ptr); })
+    .implements_by<bookmark_msg>([](const DomDeserializer* d) { return d->bookmark(); })
+    .implements_by<restore_msg>([](DomDeserializer* d, const DeserializerBookmark& b) { d->restore(b); })
+    // values are in the document, which the user owns
+    .implements_by<documentRef_msg>([](DomDeserializer*) { return DocumentRef{}; })
+    .implements_by<detach_msg>([](DomDeserializer* d) {
+        d->advance();
+        return DetachedValue(makeDetached, {}, d->current.value, 0, {});
+    })
+    .implements_by<throwDeserializerException_msg>([](const DomDeserializer* d, const std::string& msg) { d->throwException(ErrorCode::User, msg); })
+;
+
+Deserializer Make_Deserializer(const Document& doc) {
+    Deserializer ret;
+    mutate(ret, dynamix::add<DomDeserializer>(doc.root()));
+    return ret;
+}
+
+namespace
+{
+// the value is in the document, which the user owns
+Deserializer makeDetached(const DetachedValue& dv)
+{
+    Deserializer ret;
+    mutate(ret, dynamix::add<DomDeserializer>(*static_cast<const Value*>(dv.value())));
+    return ret;
+}
+}
+
+}
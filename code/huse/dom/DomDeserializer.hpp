@@ -0,0 +1,16 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "../API.h"
+#include "../DeserializerObj.hpp"
+#include <dynamix/declare_mixin.hpp>
+
+namespace huse::dom {
+DYNAMIX_DECLARE_EXPORTED_MIXIN(HUSE_API, struct DomDeserializer);
+
+class Document;
+
+// the document must outlive the deserializer
+HUSE_API Deserializer Make_Deserializer(const Document& doc);
+}
@@ -0,0 +1,239 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include "DomSerializer.hpp"
+#include "Document.hpp"
+
+#include "../SerializerObj.hpp"
+#include "../SerializerInterface.hpp"
+#include "../Exception.hpp"
+#include "../Domain.hpp"
+#include "../PolyTraits.hpp"
+#include "../Serializer.hpp"
+#include "../json/Deserializer.hpp"
+#include "../impl/Assert.hpp"
+
+#include <dynamix/define_mixin.hpp>
+#include <dynamix/mutate.hpp>
+
+#include <exception>
+#include <memory>
+#include <new>
+#include <optional>
+#include <sstream>
+#include <vector>
+
+namespace huse::dom
+{
+
+struct DomSerializer
+{
+    DomSerializer(Document& doc)
+        : m_document(doc)
+    {
+        m_document.clear();
+    }
+
+    ~DomSerializer() {
+        if (std::uncaught_exceptions()) return; // nothing smart to do
+        HUSE_ASSERT_INTERNAL(m_frames.empty());
+    }
+
+    Document& m_document;
+    Arena& arena() { return m_document.arena(); }
+
+    // values of all open compounds
+    // each open compound owns the range from its begin to the end (or to the begin of the next one)
+    // objects store key, value pairs
+    // on close the range is copied to the arena and the compound becomes a value in its parent
+    std::vector<Value> m_staging;
+
+    struct Frame
+    {
+        size_t begin;
+        bool object;
+    };
+    std::vector<Frame> m_frames;
+
+    std::optional<std::string_view> m_pendingKey;
+
+    void prepareWriteVal()
+    {
+        if (m_frames.empty()) return; // root
+
+        // compounds are created when they're closed (in destructors), so check their length here
+        auto& top = m_frames.back();
+        auto length = m_staging.size() - top.begin;
+        if (top.object) length /= 2;
+        if (length >= Value::Max_Length)
+        {
+            throw SerializerException(ErrorCode::OutOfRange, "dom values are limited to 4G elements");
+        }
+
+        if (top.object)
+        {
+            HUSE_ASSERT_INTERNAL(m_pendingKey);
+            m_staging.push_back(Value::string(*m_pendingKey, arena()));
+            m_pendingKey.reset();
+        }
+    }
+
+    // prepareWriteVal must be called before the value is created
+    void pushValue(const Value& v)
+    {
+        if (m_frames.empty()) m_document.setRoot(v);
+        else m_staging.push_back(v);
+    }
+
+    void write(const Value& v)
+    {
+        prepareWriteVal();
+        pushValue(v);
+    }
+
+    void husePolySerialize(bool val) { write(Value::boolean(val)); }
+    void husePolySerialize(std::nullptr_t) { write(Value::null()); }
+
+    void husePolySerialize(short val) { write(Value::integer(val)); }
+    void husePolySerialize(unsigned short val) { write(Value::integer(val)); }
+    void husePolySerialize(int val) { write(Value::integer(val)); }
+    void husePolySerialize(unsigned int val) { write(Value::integer(val)); }
+    void husePolySerialize(long val) { write(Value::integer(val)); }
+    void husePolySerialize(unsigned long val) { write(Value::uinteger(val)); }
+    void husePolySerialize(long long val) { write(Value::integer(val)); }
+    void husePolySerialize(unsigned long long val) { write(Value::uinteger(val)); }
+
+    void husePolySerialize(float val) { write(Value::number(val)); }
+    void husePolySerialize(double val) { write(Value::number(val)); }
+
+    void husePolySerialize(std::string_view val)
+    {
+        prepareWriteVal();
+        pushValue(Value::string(val, arena()));
+    }
+
+    void husePolySerialize(std::nullopt_t)
+    {
+        m_pendingKey.reset();
+    }
+
+    void pushKey(std::string_view k)
+    {
+        HUSE_ASSERT_INTERNAL(!m_pendingKey);
+        m_pendingKey = k;
+    }
+
+    void open(bool object)
+    {
+        prepareWriteVal();
+        m_frames.push_back({m_staging.size(), object});
+    }
+
+    void closeArray()
+    {
+        HUSE_ASSERT_INTERNAL(!m_frames.empty() && !m_frames.back().object);
+        auto begin = m_frames.back().begin;
+        m_frames.pop_back();
+
+        auto size = m_staging.size() - begin;
+        auto elements = arena().allocateArray<Value>(size);
+        std::uninitialized_copy(m_staging.begin() + begin, m_staging.end(), elements);
+        m_staging.resize(begin);
+
+        pushValue(Value::array(elements, size));
+    }
+
+    void closeObject()
+    {
+        HUSE_ASSERT_INTERNAL(!m_frames.empty() && m_frames.back().object);
+        auto begin = m_frames.back().begin;
+        m_frames.pop_back();
+
+        auto size = (m_staging.size() - begin) / 2;
+        auto members = arena().allocateArray<Member>(size);
+        auto src = m_staging.begin() + begin;
+        for (size_t i = 0; i < size; ++i, src += 2)
+        {
+            new (members + i) Member{src[0], src[1]};
+        }
+        m_staging.resize(begin);
+
+        pushValue(Value::object(members, size));
+    }
+
+    std::ostream& openStringStream()
+    {
+        prepareWriteVal();
+        HUSE_ASSERT_INTERNAL(!m_stringStreamOpen);
+        // restore the state of a freshly constructed stream
+        m_stringStream.str({});
+        m_stringStream.clear();
+        m_stringStream.flags(std::ios_base::skipws | std::ios_base::dec);
+        m_stringStream.width(0);
+        m_stringStream.precision(6);
+        m_stringStream.fill(' ');
+        m_stringStreamOpen = true;
+        return m_stringStream;
+    }
+
+    void closeStringStream()
+    {
+        HUSE_ASSERT_INTERNAL(m_stringStreamOpen);
+        m_stringStreamOpen = false;
+        pushValue(Value::string(m_stringStream.str(), arena()));
+    }
+
+    std::ostringstream m_stringStream;
+    bool m_stringStreamOpen = false;
+};
+
+DYNAMIX_DEFINE_MIXIN(Domain, DomSerializer)
+    .implements<husePolySerialize_bool>()
+    .implements<husePolySerialize_short>()
+    .implements<husePolySerialize_ushort>()
+    .implements<husePolySerialize_int>()
+    .implements<husePolySerialize_uint>()
+    .implements<husePolySerialize_long>()
+    .implements<husePolySerialize_ulong>()
+    .implements<husePolySerialize_llong>()
+    .implements<husePolySerialize_ullong>()
+    .implements<husePolySerialize_float>()
+    .implements<husePolySerialize_double>()
+    .implements<husePolySerialize_sv>()
+    .implements<husePolySerialize_nullptr_t>()
+    .implements<husePolySerialize_nullopt_t>()
+    .implements_by<openStringStream_msg>([](DomSerializer* s) -> std::ostream& {
+        return s->openStringStream();
+    })
+    .implements_by<closeStringStream_msg>([](DomSerializer* s) {
+        s->closeStringStream();
+    })
+    .implements_by<pushKey_msg>([](DomSerializer* s, std::string_view key) {
+        s->pushKey(key);
+    })
+    .implements_by<openObject_msg>([](DomSerializer* s) {
+        s->open(true);
+    })
+    .implements_by<closeObject_msg>([](DomSerializer* s) {
+        s->closeObject();
+    })
+    .implements_by<openArray_msg>([](DomSerializer* s) {
+        s->open(false);
+    })
+    .implements_by<closeArray_msg>([](DomSerializer* s) {
+        s->closeArray();
+    })
+    // raw json is parsed and written as values
+    .implements_by<writeRawJson_msg>([](DomSerializer* s, std::string_view json) {
+        auto out = Serializer::of(s)->node();
+        json::transcode(json, out);
+    })
+;
+
+Serializer Make_Serializer(Document& doc) {
+    Serializer ret;
+    mutate(ret, dynamix::add<DomSerializer>(doc));
+    return ret;
+}
+
+}
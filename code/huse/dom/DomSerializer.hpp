@@ -0,0 +1,17 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "../API.h"
+#include "../SerializerObj.hpp"
+#include <dynamix/declare_mixin.hpp>
+
+namespace huse::dom {
+DYNAMIX_DECLARE_EXPORTED_MIXIN(HUSE_API, struct DomSerializer);
+
+class Document;
+
+// the document is cleared and the serialized value becomes its root
+// the document must outlive the serializer
+HUSE_API Serializer Make_Serializer(Document& doc);
+}
@@ -0,0 +1,7 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "DomSerializer.hpp"
+#include "Document.hpp"
+#include "../Serializer.hpp"
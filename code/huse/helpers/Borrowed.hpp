@@ -0,0 +1,48 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "../Serializer.hpp"
+#include "../Deserializer.hpp"
+
+namespace huse {
+
+// a value which refers to the memory of the deserializer (std::string_view or types which
+// contain views) along with a ref which keeps that memory alive after the deserializer is
+// destroyed
+//
+//   struct Record { std::string_view name; std::vector<std::string_view> tags; ... };
+//   huse::Borrowed<Record> rec;
+//   {
+//       auto d = huse::json::Make_Deserializer(json);
+//       d.root().val(rec);
+//   }
+//   use(rec->name); // still valid
+//
+// the ref is shared, so borrow whole records rather than individual strings
+// with the json backend, the input string is copied and only the copy is kept by the ref
+// (input given as a mutable string is used in place and must be kept alive by the user)
+// if the deserializer has a memory resource, it must outlive the ref
+template <typename T>
+struct Borrowed {
+    T value = {};
+    DocumentRef ref;
+
+    T& operator*() { return value; }
+    const T& operator*() const { return value; }
+    T* operator->() { return &value; }
+    const T* operator->() const { return &value; }
+};
+
+template <typename T>
+void huseSerialize(SerializerNode& n, const Borrowed<T>& b) {
+    n.val(b.value);
+}
+
+template <typename T>
+void huseDeserialize(DeserializerNode& n, Borrowed<T>& b) {
+    b.ref = n.documentRef();
+    n.val(b.value);
+}
+
+}
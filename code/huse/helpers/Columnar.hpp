@@ -0,0 +1,105 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "StdOptional.hpp"
+#include "../Serializer.hpp"
+#include "../Deserializer.hpp"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace huse {
+
+namespace impl {
+template <typename T>
+struct IsOptional : std::false_type {};
+template <typename T>
+struct IsOptional<std::optional<T>> : std::true_type {};
+} // namespace impl
+
+// a column of Columns: a key and the member of the record in it
+template <typename Rec, typename M>
+struct Column {
+    std::string_view key;
+    M Rec::* member;
+};
+template <typename Rec, typename M>
+Column(std::string_view, M Rec::*) -> Column<Rec, M>;
+
+// a serialization functor for vectors of records in a columnar layout
+// instead of [{"sym":"A","qty":1},{"sym":"B","qty":2}] it writes
+//   {"cols":["sym","qty"],"sym":["A","B"],"qty":[1,2]}
+// so keys are not repeated for every element
+//
+// the columns are given as members of the records:
+//   obj.cval("trades", trades, huse::Columns{
+//       huse::Column{"sym", &Trade::sym},
+//       huse::Column{"qty", &Trade::qty},
+//   });
+// each column is written and read in a single loop over the records
+// all given columns are written (empty optionals as null)
+// columns which are not given are ignored on read
+// a missing column is an error, unless its member is optional, in which case it's reset
+// if no column is in the input, the vector is emptied
+template <typename... Cols>
+struct Columns {
+    std::tuple<Cols...> cols;
+    explicit Columns(Cols... c) : cols(c...) {}
+
+    template <typename Vec>
+    void operator()(SerializerNode& n, const Vec& vec) const {
+        auto obj = n.obj();
+        {
+            auto ar = obj.ar("cols");
+            std::apply([&](auto&... col) { (ar.val(col.key), ...); }, cols);
+        }
+        std::apply([&](auto&... col) { (writeColumn(obj, vec, col), ...); }, cols);
+    }
+
+    template <typename Vec>
+    void operator()(DeserializerNode& n, Vec& vec) const {
+        auto obj = n.obj();
+        bool first = true;
+        std::apply([&](auto&... col) { (readColumn(obj, vec, col, first), ...); }, cols);
+        if (first) vec.clear(); // all columns are optional and missing
+    }
+
+private:
+    template <typename Vec, typename Rec, typename M>
+    static void writeColumn(SerializerObject& obj, const Vec& vec, const Column<Rec, M>& col) {
+        auto ar = obj.ar(col.key);
+        for (auto& rec : vec) ar.val(rec.*col.member);
+    }
+
+    template <typename Vec, typename Rec, typename M>
+    static void readColumn(DeserializerObject& obj, Vec& vec, const Column<Rec, M>& col, bool& first) {
+        DeserializerNode* key;
+        if constexpr (impl::IsOptional<M>::value) {
+            key = obj.optkey(col.key);
+            if (!key) {
+                for (auto& rec : vec) (rec.*col.member).reset();
+                return;
+            }
+        }
+        else {
+            key = &obj.key(col.key);
+        }
+
+        auto ar = key->ar();
+        auto len = ar.length();
+        if (first) {
+            vec.resize(len);
+            first = false;
+        }
+        else if (len != vec.size()) {
+            ar.throwException("column " + std::string(col.key) + " has a different length");
+        }
+        for (auto& rec : vec) ar.val(rec.*col.member);
+    }
+};
+
+}
@@ -0,0 +1,301 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "../Serializer.hpp"
+#include "../SerializerInterface.hpp"
+#include "../Deserializer.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace huse {
+
+// an entry of a name table for EnumAsString
+template <typename E>
+struct EnumName {
+    E value;
+    std::string_view name;
+};
+
+namespace impl {
+
+template <typename T>
+struct EnumNamesTraits;
+template <typename E, size_t N>
+struct EnumNamesTraits<EnumName<E>[N]> {
+    using Enum = E;
+    static constexpr size_t size = N;
+};
+template <typename E, size_t N>
+struct EnumNamesTraits<std::array<EnumName<E>, N>> {
+    using Enum = E;
+    static constexpr size_t size = N;
+};
+
+template <auto& Names>
+using EnumNamesTraitsOf = EnumNamesTraits<std::remove_cv_t<std::remove_reference_t<decltype(Names)>>>;
+
+// the finalizer of murmur3
+constexpr uint64_t enumHashMix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+// fnv-1a, mixed so that the last characters affect the high bits
+// (names often differ only in a suffix)
+constexpr uint64_t enumNameHash(std::string_view str) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (char c : str) {
+        h ^= uint8_t(c);
+        h *= 0x100000001b3ull;
+    }
+    return enumHashMix(h);
+}
+
+// the slot of a hash with a displacement
+constexpr uint64_t enumNameSlotHash(uint64_t h, uint64_t d) {
+    return enumHashMix(h + d * 0x9e3779b97f4a7c15ull);
+}
+
+constexpr size_t pow2AtLeast(size_t n) {
+    size_t ret = 1;
+    while (ret < n) ret *= 2;
+    return ret;
+}
+
+// names which the json serializer writes as they are (see escapeUtf8Byte in JsonSerializer.cpp)
+constexpr bool enumNameNeedsEscape(std::string_view str) {
+    for (char c : str) {
+        auto u = uint8_t(c);
+        if (u < ' ' || c == '"' || c == '\\') return true;
+    }
+    return false;
+}
+
+template <typename Names>
+constexpr size_t enumQuotedSize(const Names& names) {
+    size_t ret = 0;
+    for (auto& n : names) ret += n.name.size() + 2;
+    return ret;
+}
+
+// the lookup tables of a name table, built at compile time
+//
+// names are found with a perfect hash (hash and displace):
+// a name's hash selects a bucket and the displacement of the bucket selects its slot
+// the displacements are chosen so that no two names share a slot
+// so a lookup is a hash of the string and a single string comparison
+//
+// values are found by index if they are contiguous and with a binary search otherwise
+template <size_t N, size_t Quoted_Size>
+struct EnumTable {
+    static constexpr size_t Num_Slots = pow2AtLeast(N + N / 4);
+    static constexpr size_t Num_Buckets = pow2AtLeast((N + 3) / 4);
+    static constexpr uint32_t Max_Displacement = 1 << 16;
+
+    bool ok = false;
+
+    uint32_t displacements[Num_Buckets] = {};
+    uint32_t slots[Num_Slots] = {}; // index of the name + 1, zero for empty slots
+
+    int64_t values[N] = {}; // the underlying values sorted
+    uint32_t byValue[N] = {}; // the indices of the names in the same order
+    bool contiguous = false;
+
+    char quoted[Quoted_Size] = {}; // "name1""name2"...
+    size_t quotedBegin[N] = {};
+    bool needsEscape[N] = {};
+
+    constexpr size_t slot(uint64_t hash) const {
+        auto d = displacements[(hash >> 32) & (Num_Buckets - 1)];
+        return size_t(enumNameSlotHash(hash, d) & (Num_Slots - 1));
+    }
+
+    // index of the first name with this value or -1
+    constexpr size_t findValue(int64_t v) const {
+        if (contiguous) {
+            auto i = uint64_t(v) - uint64_t(values[0]);
+            return i < N ? byValue[i] : size_t(-1);
+        }
+        size_t begin = 0, end = N;
+        while (begin < end) {
+            auto mid = begin + (end - begin) / 2;
+            if (values[mid] < v) begin = mid + 1;
+            else end = mid;
+        }
+        return begin < N && values[begin] == v ? byValue[begin] : size_t(-1);
+    }
+
+    constexpr std::string_view quotedName(size_t i, size_t nameSize) const {
+        return std::string_view(quoted + quotedBegin[i], nameSize + 2);
+    }
+};
+
+template <size_t N, size_t Quoted_Size, typename Names>
+constexpr auto makeEnumTable(const Names& names) {
+    using Table = EnumTable<N, Quoted_Size>;
+    Table t;
+
+    // quoted names
+    size_t q = 0;
+    for (size_t i = 0; i < N; ++i) {
+        auto name = names[i].name;
+        t.quotedBegin[i] = q;
+        t.quoted[q++] = '"';
+        for (char c : name) t.quoted[q++] = c;
+        t.quoted[q++] = '"';
+        t.needsEscape[i] = enumNameNeedsEscape(name);
+    }
+
+    // values: insertion sort which keeps the table order for equal values
+    for (size_t i = 0; i < N; ++i) {
+        auto v = int64_t(names[i].value);
+        size_t j = i;
+        while (j > 0 && t.values[j - 1] > v) {
+            t.values[j] = t.values[j - 1];
+            t.byValue[j] = t.byValue[j - 1];
+            --j;
+        }
+        t.values[j] = v;
+        t.byValue[j] = uint32_t(i);
+    }
+    t.contiguous = true;
+    for (size_t i = 1; i < N; ++i) {
+        if (t.values[i] != t.values[i - 1] + 1) t.contiguous = false;
+    }
+
+    // perfect hash
+    uint64_t hashes[N] = {};
+    size_t bucketSizes[Table::Num_Buckets] = {};
+    size_t maxBucketSize = 0;
+    for (size_t i = 0; i < N; ++i) {
+        hashes[i] = enumNameHash(names[i].name);
+        auto& size = bucketSizes[(hashes[i] >> 32) & (Table::Num_Buckets - 1)];
+        ++size;
+        if (size > maxBucketSize) maxBucketSize = size;
+    }
+
+    // place the biggest buckets first, while the table is empty
+    size_t members[N] = {};
+    size_t memberSlots[N] = {};
+    for (size_t size = maxBucketSize; size > 0; --size) {
+        for (size_t b = 0; b < Table::Num_Buckets; ++b) {
+            if (bucketSizes[b] != size) continue;
+
+            size_t numMembers = 0;
+            for (size_t i = 0; i < N; ++i) {
+                if (((hashes[i] >> 32) & (Table::Num_Buckets - 1)) == b) members[numMembers++] = i;
+            }
+
+            bool placed = false;
+            for (uint32_t d = 0; d < Table::Max_Displacement && !placed; ++d) {
+                placed = true;
+                for (size_t m = 0; m < numMembers && placed; ++m) {
+                    auto s = size_t(enumNameSlotHash(hashes[members[m]], d) & (Table::Num_Slots - 1));
+                    if (t.slots[s]) placed = false;
+                    for (size_t o = 0; o < m && placed; ++o) {
+                        if (memberSlots[o] == s) placed = false;
+                    }
+                    memberSlots[m] = s;
+                }
+                if (placed) {
+                    t.displacements[b] = d;
+                    for (size_t m = 0; m < numMembers; ++m) {
+                        t.slots[memberSlots[m]] = uint32_t(members[m] + 1);
+                    }
+                }
+            }
+
+            // only duplicate names (or colliding hashes) can't be placed
+            if (!placed) return t;
+        }
+    }
+
+    t.ok = true;
+    return t;
+}
+
+} // namespace impl
+
+// a serialization functor for enums as strings, driven by a constexpr name table
+//
+//   enum class Status { Active, Inactive, Deleted };
+//   inline constexpr huse::EnumName<Status> Status_Names[] = {
+//       {Status::Active, "ACTIVE"},
+//       {Status::Inactive, "INACTIVE"},
+//       {Status::Deleted, "DELETED"},
+//   };
+//   obj.cval("status", s.status, huse::EnumAsString<Status_Names>{});
+//
+// the table can also be a std::array
+// names are written as pre-quoted json when the serializer accepts raw json and read with a
+// perfect hash built at compile time
+// values can have several names (the first one is written)
+// unknown names are read as the fallback value if there is one and throw otherwise
+// writing a value which is not in the table throws
+template <auto& Names>
+struct EnumAsString {
+    using Traits = impl::EnumNamesTraitsOf<Names>;
+    using Enum = typename Traits::Enum;
+    static_assert(std::is_enum_v<Enum>, "EnumAsString is for enums");
+    static_assert(Traits::size > 0, "empty name table");
+
+    static constexpr auto table = impl::makeEnumTable<Traits::size, impl::enumQuotedSize(Names)>(Names);
+    static_assert(table.ok, "duplicate names in enum name table");
+
+    std::optional<Enum> unknownVal;
+    explicit EnumAsString(std::optional<Enum> unknown = std::nullopt) : unknownVal(unknown) {}
+
+    static constexpr std::optional<Enum> fromString(std::string_view str) {
+        auto i = table.slots[table.slot(impl::enumNameHash(str))];
+        if (i && Names[i - 1].name == str) return Names[i - 1].value;
+        return std::nullopt;
+    }
+
+    // empty if the value is not in the table
+    static constexpr std::string_view toString(Enum e) {
+        auto i = table.findValue(int64_t(e));
+        if (i == size_t(-1)) return {};
+        return Names[i].name;
+    }
+
+    void operator()(SerializerNode& n, Enum e) const {
+        auto i = table.findValue(int64_t(e));
+        if (i == size_t(-1)) {
+            throwSerializerException(n._s(), "unknown enum value " + std::to_string(int64_t(e)));
+        }
+        auto name = Names[i].name;
+        if (!table.needsEscape[i] && acceptsRawJson_msg::call(n._s())) {
+            n.raw(table.quotedName(i, name.size()));
+        }
+        else {
+            n.val(name);
+        }
+    }
+
+    void operator()(DeserializerNode& n, Enum& e) const {
+        std::string_view str;
+        n.val(str);
+        if (auto v = fromString(str)) {
+            e = *v;
+        }
+        else if (unknownVal) {
+            e = *unknownVal;
+        }
+        else {
+            throwDeserializerException(n._s(), "unknown enum name " + std::string(str));
+        }
+    }
+};
+
+}
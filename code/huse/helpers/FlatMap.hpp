@@ -0,0 +1,78 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "MapLike.hpp"
+
+#include <algorithm>
+
+namespace huse {
+
+// a serialization functor for flat maps: vectors of pairs sorted by key
+// written like MapLike
+// on read the vector is replaced: it's reserved once, filled, and sorted with a single stable
+// sort (skipped if the elements are already sorted)
+// if there are duplicate keys, the last one is kept (as with maps read by MapLike)
+struct FlatMapLike {
+    bool compact;
+    explicit FlatMapLike(bool compact = false) : compact(compact) {}
+
+    template <typename Vec>
+    void operator()(SerializerNode& n, const Vec& vec) const {
+        MapLike{compact}(n, vec);
+    }
+
+    template <typename Vec>
+    void operator()(DeserializerNode& n, Vec& vec) const {
+        vec.clear();
+
+        if constexpr (std::is_convertible_v<impl::MapKeyType<Vec>, std::string_view>) {
+            auto obj = n.obj();
+            const size_t len = obj.length();
+            vec.reserve(len);
+            for (size_t i = 0; i < len; ++i) {
+                auto& e = vec.emplace_back();
+                obj.nextkeyval(e.first, e.second);
+            }
+        }
+        else {
+            auto ar = n.ar();
+            const size_t len = ar.length();
+            vec.reserve(len);
+            if (!len) return;
+
+            auto first = ar.peeknext();
+            const bool compactPairs = first->type().is(Type::Array);
+            for (size_t i = 0; i < len; ++i) {
+                auto& e = vec.emplace_back();
+                if (compactPairs) {
+                    auto pair = ar.ar();
+                    pair.val(e.first);
+                    pair.val(e.second);
+                }
+                else {
+                    auto pair = ar.obj();
+                    pair.val("key", e.first);
+                    pair.val("value", e.second);
+                }
+            }
+        }
+
+        auto less = [](const auto& a, const auto& b) { return a.first < b.first; };
+        if (!std::is_sorted(vec.begin(), vec.end(), less)) {
+            std::stable_sort(vec.begin(), vec.end(), less);
+        }
+
+        // equal keys are in input order: keep the last of each
+        auto out = vec.begin();
+        for (auto i = vec.begin(); i != vec.end(); ++i) {
+            auto next = i + 1;
+            if (next != vec.end() && next->first == i->first) continue;
+            if (out != i) *out = std::move(*i);
+            ++out;
+        }
+        vec.erase(out, vec.end());
+    }
+};
+
+}
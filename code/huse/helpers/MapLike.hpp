@@ -5,18 +5,112 @@
 #include "../Serializer.hpp"
 #include "../Deserializer.hpp"
 
+#include <algorithm>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
 namespace huse {
 
+namespace impl {
+template <typename, typename = void>
+struct HasReserveMethod : std::false_type {};
+template <typename C>
+struct HasReserveMethod<C, std::void_t<decltype(std::declval<C&>().reserve(size_t(0)))>> : std::true_type {};
+
+template <typename C>
+void reserveIfSupported(C& c, size_t size) {
+    if constexpr (HasReserveMethod<C>::value) {
+        c.reserve(size);
+    }
+}
+
+template <typename, typename = void>
+struct HasHeterogeneousFind : std::false_type {};
+template <typename Map>
+struct HasHeterogeneousFind<Map, std::void_t<decltype(std::declval<Map&>().find(std::declval<std::string_view>()))>> : std::true_type {};
+
+// works for maps and for sequences of pairs
+template <typename Map>
+using MapKeyType = std::decay_t<decltype(std::declval<const Map&>().begin()->first)>;
+
+template <typename, typename = void>
+struct HasGetAllocator : std::false_type {};
+template <typename C>
+struct HasGetAllocator<C, std::void_t<decltype(std::declval<const C&>().get_allocator())>> : std::true_type {};
+
+template <typename T, typename Alloc>
+auto allocatorArgs(const Alloc& a) {
+    if constexpr (std::uses_allocator_v<T, Alloc> && std::is_constructible_v<T, const Alloc&>) {
+        return std::tuple<const Alloc&>(a);
+    }
+    else {
+        return std::tuple<>();
+    }
+}
+
+// a key to be read and looked up in the map
+// keys which use allocators get the allocator of the map (as with std::pmr)
+// so that moving them into the map doesn't copy them
+template <typename Map>
+typename Map::key_type newKey(DeserializerNode& n, const Map& map) {
+    using K = typename Map::key_type;
+    if constexpr (NeedsMemoryResource<K, Map>) {
+        return K(n._s().memoryResource());
+    }
+    else if constexpr (HasGetAllocator<Map>::value) {
+        return std::make_from_tuple<K>(allocatorArgs<K>(map.get_allocator()));
+    }
+    else {
+        return K{};
+    }
+}
+
+// the value of a key, added if the key is not in the map
+template <typename Map>
+typename Map::mapped_type& valueOf(DeserializerNode& n, Map& map, typename Map::key_type&& key) {
+    if constexpr (NeedsMemoryResource<typename Map::mapped_type, Map>) {
+        return map.try_emplace(std::move(key), n._s().memoryResource()).first->second;
+    }
+    else {
+        return map.try_emplace(std::move(key)).first->second;
+    }
+}
+} // namespace impl
+
 // a serialization functor for map-like objects
+// maps with string keys are objects
+// maps with other keys are arrays of pairs:
+// * [{"key":k,"value":v},...] by default
+// * [[k,v],...] when compact (smaller and read without key lookups)
+// both layouts of pairs are accepted on read regardless of the mode
+//
+// on read, the entries of keys which are already in the map are read into (like other values,
+// they reuse their memory) and the other keys are added
+// entries whose keys are not in the input are kept: clear the map first to replace it
+// maps with string keys which support lookup by std::string_view (like std::map with std::less<>)
+// find existing entries without allocating a key for them
 struct MapLike {
+    bool compact;
+    explicit MapLike(bool compact = false) : compact(compact) {}
+
     template <typename Map>
     void operator()(SerializerNode& n, const Map& map) const {
-        if constexpr (std::is_convertible_v<typename Map::key_type, std::string_view>) {
+        if constexpr (std::is_convertible_v<impl::MapKeyType<Map>, std::string_view>) {
             auto obj = n.obj();
             for (auto& val : map) {
                 obj.val(val.first, val.second);
             }
         }
+        else if (compact) {
+            auto ar = n.ar();
+            for (auto& val : map) {
+                auto pair = ar.ar();
+                pair.val(val.first);
+                pair.val(val.second);
+            }
+        }
         else {
             auto ar = n.ar();
             for (auto& val : map) {
@@ -29,26 +123,46 @@ struct MapLike {
 
     template <typename Map>
     void operator()(DeserializerNode& n, Map& map) const {
-        using KvPair = std::pair<typename Map::key_type, typename Map::mapped_type>;
-
-        if constexpr (std::is_convertible_v<typename Map::key_type, std::string_view>) {
+        using Key = typename Map::key_type;
+        if constexpr (std::is_convertible_v<Key, std::string_view>) {
             auto obj = n.obj();
-            const int len = obj.length();
-            for (int i = 0; i < len; ++i) {
-                KvPair val;
-                obj.nextkeyval(val.first, val.second);
-                map.emplace(std::move(val));
+            const size_t len = obj.length();
+            impl::reserveIfSupported(map, std::max(map.size(), len)); // the keys may be in the map
+            for (size_t i = 0; i < len; ++i) {
+                auto q = obj.peeknext();
+                if constexpr (impl::HasHeterogeneousFind<Map>::value) {
+                    auto f = map.find(q.name);
+                    if (f != map.end()) {
+                        q->val(f->second);
+                        continue;
+                    }
+                }
+                auto key = impl::newKey(n, map);
+                if constexpr (std::is_assignable_v<Key&, std::string_view>) key = q.name;
+                else key = Key(q.name);
+                q->val(impl::valueOf(n, map, std::move(key)));
             }
         }
         else {
             auto ar = n.ar();
-            const int len = ar.length();
-            for (int i = 0; i < len; ++i) {
-                KvPair val;
-                auto pair = ar.obj();
-                pair.val("key", val.first);
-                pair.val("value", val.second);
-                map.emplace(std::move(val));
+            const size_t len = ar.length();
+            impl::reserveIfSupported(map, std::max(map.size(), len)); // the keys may be in the map
+            if (!len) return;
+
+            auto first = ar.peeknext();
+            const bool compactPairs = first->type().is(Type::Array);
+            for (size_t i = 0; i < len; ++i) {
+                auto key = impl::newKey(n, map);
+                if (compactPairs) {
+                    auto pair = ar.ar();
+                    pair.val(key);
+                    pair.val(impl::valueOf(n, map, std::move(key)));
+                }
+                else {
+                    auto pair = ar.obj();
+                    pair.val("key", key);
+                    pair.val("value", impl::valueOf(n, map, std::move(key)));
+                }
             }
         }
     }
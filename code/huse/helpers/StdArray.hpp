@@ -0,0 +1,55 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "../Serializer.hpp"
+#include "../Deserializer.hpp"
+
+#include <array>
+#include <string>
+#include <type_traits>
+
+namespace huse {
+
+namespace impl {
+template <typename T>
+void serializeFixedArray(SerializerNode& n, const T* begin, size_t size) {
+    auto ar = n.ar();
+    for (size_t i = 0; i < size; ++i) {
+        ar.val(begin[i]);
+    }
+}
+
+// the length of the value must match
+template <typename T>
+void deserializeFixedArray(DeserializerNode& n, T* begin, size_t size) {
+    auto ar = n.ar();
+    if (ar.length() != size) {
+        n.throwException("expected an array of " + std::to_string(size) + " elements, got " + std::to_string(ar.length()));
+    }
+    for (size_t i = 0; i < size; ++i) {
+        ar.val(begin[i]);
+    }
+}
+} // namespace impl
+
+template <typename T, size_t N>
+void huseSerialize(SerializerNode& n, const std::array<T, N>& arr) {
+    impl::serializeFixedArray(n, arr.data(), N);
+}
+template <typename T, size_t N>
+void huseDeserialize(DeserializerNode& n, std::array<T, N>& arr) {
+    impl::deserializeFixedArray(n, arr.data(), N);
+}
+
+// c arrays (char arrays are strings)
+template <typename T, size_t N, std::enable_if_t<!std::is_same_v<std::remove_cv_t<T>, char>, int> = 0>
+void huseSerialize(SerializerNode& n, const T(&arr)[N]) {
+    impl::serializeFixedArray(n, arr, N);
+}
+template <typename T, size_t N, std::enable_if_t<!std::is_same_v<T, char>, int> = 0>
+void huseDeserialize(DeserializerNode& n, T(&arr)[N]) {
+    impl::deserializeFixedArray(n, arr, N);
+}
+
+}
@@ -0,0 +1,32 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "../Serializer.hpp"
+#include "../Deserializer.hpp"
+
+#include <optional>
+
+namespace huse {
+
+// optional values which are not object members (those are omitted when empty)
+// empty optionals are null
+template <typename T>
+void huseSerialize(SerializerNode& n, const std::optional<T>& opt) {
+    if (opt) n.val(*opt);
+    else n.val(nullptr);
+}
+
+// an engaged optional is read into, so the memory of its value can be reused
+template <typename T>
+void huseDeserialize(DeserializerNode& n, std::optional<T>& opt) {
+    if (n.type().is(Type::Null)) {
+        n.skip();
+        opt.reset();
+        return;
+    }
+    if (!opt) impl::emplaceNew(n._s(), opt);
+    n.val(*opt);
+}
+
+}
@@ -0,0 +1,41 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "StdVector.hpp"
+#include "StdMap.hpp"
+
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+namespace huse {
+
+// std::pmr strings, and std::pmr containers through the usual helpers
+//
+// a memory resource can't be changed after construction, so existing values keep theirs:
+// construct the values which are read into with the resource of the deserializer
+// (or another one which outlives them)
+// the values which the helpers construct while reading (elements of vectors, entries of maps,
+// optional values) get the resource of their container if it's a std::pmr one, as usual,
+// and the one of the deserializer (see Deserializer::setMemoryResource) otherwise
+//
+//   std::pmr::monotonic_buffer_resource arena;
+//   auto d = huse::json::Make_Deserializer(json);
+//   d.setMemoryResource(&arena);
+//   std::pmr::vector<std::pmr::string> tags(&arena);
+//   d.root().val(tags);
+
+// templates, so that other types (like nullptr) aren't implicitly converted to strings
+template <typename Traits>
+void huseSerialize(SerializerNode& n, const std::basic_string<char, Traits, std::pmr::polymorphic_allocator<char>>& str) {
+    n.val(std::string_view(str));
+}
+template <typename Traits>
+void huseDeserialize(DeserializerNode& n, std::basic_string<char, Traits, std::pmr::polymorphic_allocator<char>>& str) {
+    std::string_view sv;
+    n.val(sv);
+    str.assign(sv);
+}
+
+}
@@ -0,0 +1,20 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "MapLike.hpp"
+
+#include <unordered_map>
+
+namespace huse {
+// note that the order of the elements in the output is unspecified
+template <typename K, typename V, typename H, typename E, typename A>
+void huseSerialize(SerializerNode& n, const std::unordered_map<K, V, H, E, A>& map) {
+    MapLike{}(n, map);
+}
+// the map is reserved for the elements of the value before reading them
+template <typename K, typename V, typename H, typename E, typename A>
+void huseDeserialize(DeserializerNode& n, std::unordered_map<K, V, H, E, A>& map) {
+    MapLike{}(n, map);
+}
+}
@@ -0,0 +1,83 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "../Serializer.hpp"
+#include "../Deserializer.hpp"
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace huse {
+
+// the types of values a C++ type can be read from
+// used to choose the alternative of a variant to read
+// specialize it for types which are not objects
+template <typename T, typename = void>
+struct TypeMask {
+    static constexpr int value =
+        std::is_same_v<T, bool> ? Type::Boolean
+        : std::is_integral_v<T> ? Type::Integer
+        : std::is_floating_point_v<T> ? Type::Number
+        : Type::Object;
+};
+template <typename C, typename Tr, typename A>
+struct TypeMask<std::basic_string<C, Tr, A>> { static constexpr int value = Type::String; };
+template <typename C, typename Tr>
+struct TypeMask<std::basic_string_view<C, Tr>> { static constexpr int value = Type::String; };
+template <>
+struct TypeMask<std::nullptr_t> { static constexpr int value = Type::Null; };
+template <>
+struct TypeMask<std::monostate> { static constexpr int value = Type::Null; };
+template <typename T>
+struct TypeMask<std::optional<T>> { static constexpr int value = TypeMask<T>::value | Type::Null; };
+template <typename T, typename A>
+struct TypeMask<std::vector<T, A>> { static constexpr int value = Type::Array; };
+template <typename T, size_t N>
+struct TypeMask<std::array<T, N>> { static constexpr int value = Type::Array; };
+
+inline void huseSerialize(SerializerNode& n, std::monostate) {
+    n.val(nullptr);
+}
+inline void huseDeserialize(DeserializerNode& n, std::monostate&) {
+    n.skip();
+}
+
+// the held alternative is written as it is
+template <typename... Ts>
+void huseSerialize(SerializerNode& n, const std::variant<Ts...>& var) {
+    std::visit([&](const auto& v) { n.val(v); }, var);
+}
+
+namespace impl {
+template <size_t I, typename Variant>
+bool deserializeVariantAlternative(DeserializerNode& n, Type type, Variant& var) {
+    if constexpr (I == std::variant_size_v<Variant>) {
+        return false;
+    }
+    else {
+        using Alt = std::variant_alternative_t<I, Variant>;
+        if (!type.is(Type::Value(TypeMask<Alt>::value))) return deserializeVariantAlternative<I + 1>(n, type, var);
+        // read into the current alternative if it's the same, so its memory can be reused
+        if (var.index() != I) var.template emplace<I>();
+        n.val(std::get<I>(var));
+        return true;
+    }
+}
+} // namespace impl
+
+// the first alternative whose TypeMask matches the type of the value is read
+template <typename... Ts>
+void huseDeserialize(DeserializerNode& n, std::variant<Ts...>& var) {
+    if (!impl::deserializeVariantAlternative<0>(n, n.type(), var)) {
+        n.throwException("no alternative of the variant matches the type of the value");
+    }
+}
+
+}
@@ -8,6 +8,11 @@
 namespace huse {
 
 // a serialization functor for vector-like objects
+// on read, existing elements are read into, so that they can reuse their memory,
+// and only elements beyond the current size are constructed
+// a shorter input destroys the elements past its length: the vector keeps its capacity, but
+// the memory of those elements is freed and a later longer input allocates it again
+// new std::pmr elements of other containers get the memory resource of the deserializer
 struct VectorLike{
     template <typename Vec>
     void operator()(SerializerNode& n, const Vec& vec) const  {
@@ -21,8 +26,16 @@ struct VectorLike{
     template <typename Vec>
     void operator()(DeserializerNode& n, Vec& vec) const {
         auto ar = n.ar();
-        auto len = ar.length();
-        vec.resize(size_t(len));
+        const size_t len = ar.length();
+        if constexpr (impl::NeedsMemoryResource<typename Vec::value_type, Vec>) {
+            if (len < vec.size()) vec.resize(len);
+            vec.reserve(len);
+            auto r = n._s().memoryResource();
+            while (vec.size() < len) vec.emplace_back(r);
+        }
+        else {
+            vec.resize(len);
+        }
         for (auto& val : vec)
         {
             ar.val(val);
@@ -7,7 +7,10 @@
 #include "../DeserializerInterface.hpp"
 #include "../Domain.hpp"
 #include "../Exception.hpp"
+#include "../JsonPointer.hpp"
 #include "../PolyTraits.hpp"
+#include "../Deserializer.hpp"
+#include "../Transcode.hpp"
 #include "../impl/Assert.hpp"
 
 #include "_sajson/sajson.hpp"
@@ -20,7 +23,13 @@
 #include <vector>
 #include <string>
 #include <cmath>
-#include <sstream>
+#include <istream>
+#include <algorithm>
+#include <memory>
+#include <memory_resource>
+#include <cstring>
+#include <utility>
+#include <type_traits>
 
 namespace huse::json
 {
@@ -29,6 +38,7 @@ namespace
 {
 constexpr std::string_view Not_Integer = "not an integer";
 constexpr std::string_view Out_of_Range = "out of range";
+constexpr std::string_view Negative_Integer = "negative integer";
 
 struct MemIStream
 {
@@ -40,80 +50,300 @@ struct MemIStream
     itlib::mem_istreambuf<char> streambuf;
     std::istream stream;
 };
+
+// lexical helpers for the retained source
+// the source has been validated by the parser, so they don't check for errors
+bool isWs(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+size_t skipWs(std::string_view src, size_t pos)
+{
+    while (pos < src.size() && isWs(src[pos])) ++pos;
+    return pos;
+}
+
+// pos is at the opening quote
+size_t skipString(std::string_view src, size_t pos)
+{
+    ++pos;
+    while (true)
+    {
+        auto c = src[pos];
+        if (c == '"') return pos + 1;
+        if (c == '\\') pos += 2;
+        else ++pos;
+    }
+}
+
+size_t skipValue(std::string_view src, size_t pos)
+{
+    auto c = src[pos];
+    if (c == '"') return skipString(src, pos);
+    if (c == '{' || c == '[')
+    {
+        int depth = 0;
+        while (true)
+        {
+            c = src[pos];
+            if (c == '"')
+            {
+                pos = skipString(src, pos);
+                continue;
+            }
+            if (c == '{' || c == '[') ++depth;
+            else if ((c == '}' || c == ']') && --depth == 0) return pos + 1;
+            ++pos;
+        }
+    }
+
+    // number or literal
+    while (pos < src.size())
+    {
+        c = src[pos];
+        if (c == ',' || c == ']' || c == '}' || isWs(c)) break;
+        ++pos;
+    }
+    return pos;
+}
+
+constexpr size_t npos = std::string_view::npos;
+
+// buffers for the document
+// * a copy of immutable input, in which the parser writes strings and keys
+//   it can outlive the deserializer (see share)
+// * the ast when it's allocated from DeserializerOptions::memoryResource
+// both come from the resource if there is one
+struct DocumentBuffers
+{
+    std::pmr::memory_resource* resource = nullptr;
+    char* text = nullptr;
+    size_t textSize = 0;
+    DocumentRef sharedText; // owns the text when set
+    size_t* ast = nullptr;
+    size_t astSize = 0;
+
+    explicit DocumentBuffers(std::pmr::memory_resource* r) : resource(r) {}
+    DocumentBuffers(DocumentBuffers&& other) noexcept
+        : resource(other.resource)
+        , text(std::exchange(other.text, nullptr))
+        , textSize(other.textSize)
+        , sharedText(std::move(other.sharedText))
+        , ast(std::exchange(other.ast, nullptr))
+        , astSize(other.astSize)
+    {}
+    DocumentBuffers& operator=(DocumentBuffers&&) = delete;
+    ~DocumentBuffers()
+    {
+        if (text && !sharedText) freeText(resource, text, textSize);
+        if (ast) resource->deallocate(ast, astSize * sizeof(size_t), alignof(size_t));
+    }
+
+    static void freeText(std::pmr::memory_resource* r, char* text, size_t size)
+    {
+        if (r) r->deallocate(text, size, alignof(char));
+        else delete[] text;
+    }
+
+    char* copyText(std::string_view str)
+    {
+        textSize = std::max(str.size(), size_t(1));
+        text = resource
+            ? static_cast<char*>(resource->allocate(textSize, alignof(char)))
+            : new char[textSize];
+        std::memcpy(text, str.data(), str.size());
+        return text;
+    }
+
+    // sajson needs a word per byte of input
+    size_t* allocateAst(size_t inputSize)
+    {
+        astSize = std::max(inputSize, size_t(1));
+        ast = static_cast<size_t*>(resource->allocate(astSize * sizeof(size_t), alignof(size_t)));
+        return ast;
+    }
+
+    // pass the ownership of the text to a shared pointer, so values can refer to it after
+    // the deserializer is gone
+    // empty for mutable input, which the user owns
+    DocumentRef share()
+    {
+        if (!text) return {};
+        if (!sharedText)
+        {
+            sharedText.reset(text, [r = resource, size = textSize](char* p) {
+                freeText(r, p, size);
+            });
+        }
+        return sharedText;
+    }
+};
+
+// the document moved to shared memory, so that detached values can keep it alive
+// the text and the ast don't move, so values which refer to them remain valid
+struct SharedDocument
+{
+    DocumentBuffers buffers;
+    sajson::document document;
+
+    SharedDocument(DocumentBuffers&& bufs, sajson::document&& doc)
+        : buffers(std::move(bufs))
+        , document(std::move(doc))
+    {}
+};
 }
 
 struct JsonDeserializer
 {
+    DocumentBuffers buffers; // must outlive the document
     sajson::document document;
 
+    // buffers and document are moved here when a value is detached
+    std::shared_ptr<SharedDocument> m_shared;
+    sajson::value m_rootValue;
+
     struct Value
     {
         sajson::value sjvalue;
         std::string_view key;
-        int index;
+        size_t index;
     };
 
     struct StackElement
     {
         Value value;
         std::optional<Value> pending;
+
+        // positions in the retained source (if any), found lazily
+        size_t srcBegin = npos; // opening bracket
+        size_t srcEnd = npos; // end of the furthest element whose source is known
+
+        // in arrays: position at or before the element with this index
+        // allows reading the source of sequential elements without rescanning
+        struct Cursor
+        {
+            size_t index;
+            size_t offset;
+        };
+        Cursor cursor = {0, npos};
     };
     std::vector<StackElement> stack;
+    static constexpr size_t Initial_Stack_Capacity = 16;
 
     Value current; // only valid after advance
 
     std::optional<MemIStream> m_stringStream;
 
-    JsonDeserializer(sajson::document&& doc)
-        : document(std::move(doc))
+    // error state for when we don't throw on error
+    // only the first error is recorded
+    // the text is only formatted if requested
+    // shared with the results of Deserializer::tryVal
+    const bool m_throwOnError;
+    std::shared_ptr<const DeserializerException> m_error;
+
+    // unmodified input, empty if not retained
+    const std::string_view m_source;
+
+    // root set by a json pointer (see loadPointer)
+    std::optional<Value> m_pointerRoot;
+    std::string m_pointerText;
+    size_t m_pointerSource = npos;
+
+    JsonDeserializer(DocumentBuffers&& bufs, sajson::document&& doc, const DeserializerOptions& opts, std::string_view source = {})
+        : buffers(std::move(bufs))
+        , document(std::move(doc))
+        , m_throwOnError(opts.throwOnError)
+        , m_source(source)
     {
+        // so that reading typical documents doesn't allocate
+        stack.reserve(Initial_Stack_Capacity);
+
         if (!document.is_valid()) {
             // don't use d->throwException because it adds the stack
             // we certainly don't have a stack here
-            throw DeserializerException(document.get_error_message_as_cstring());
+            DeserializerException ex(ErrorCode::Syntax, document.get_error_message_as_cstring());
+            if (m_throwOnError) throw ex;
+            m_error = std::make_shared<DeserializerException>(std::move(ex));
         }
+        m_rootValue = document.get_root();
+    }
+
+    // a deserializer of a detached value
+    JsonDeserializer(std::shared_ptr<SharedDocument> shared, sajson::value root)
+        : buffers(nullptr)
+        , m_shared(std::move(shared))
+        , m_rootValue(root)
+        , m_throwOnError(true)
+    {
+        stack.reserve(Initial_Stack_Capacity);
     }
 
     ~JsonDeserializer() {
         HUSE_ASSERT_INTERNAL(stack.size() == 0);
     }
 
+    bool failed() const { return !!m_error; }
+
+    // throw or record the error depending on the mode
+    // when this returns, the caller must not touch the value further
+    void error(ErrorCode code, std::string_view msg)
+    {
+        if (m_throwOnError) throwException(code, msg);
+        if (failed()) return;
+        m_error = std::make_shared<DeserializerException>(exception(code, msg));
+    }
+
     template <typename Target, typename Source>
-    Target signedCheck(Source s)
+    void assignChecked(Target& t, Source s)
     {
         if constexpr (std::is_unsigned_v<Target>)
         {
-            if (s < 0) throwException("negative integer");
+            if (s < 0)
+            {
+                error(ErrorCode::NumberRange, Negative_Integer);
+                return;
+            }
         }
-        return Target(s);
+        t = Target(s);
     }
 
     template <typename T>
     void readInt(T& val)
     {
         auto jval = r();
-        if (jval.get_type() != sajson::TYPE_INTEGER) throwException(Not_Integer);
-        val = signedCheck<T>(jval.get_integer_value());
+        if (failed()) return;
+        if (jval.get_type() != sajson::TYPE_INTEGER)
+        {
+            error(ErrorCode::TypeMismatch, Not_Integer);
+            return;
+        }
+        assignChecked(val, jval.get_integer_value());
     }
 
     template <typename T>
     void readLargeInt(T& val)
     {
         auto jval = r();
+        if (failed()) return;
         if (jval.get_type() == sajson::TYPE_INTEGER)
         {
-            val = signedCheck<T>(jval.get_integer_value());
+            assignChecked(val, jval.get_integer_value());
         }
         else if (jval.get_type() == sajson::TYPE_DOUBLE)
         {
             auto d = jval.get_double_value();
             double tmp;
-            if (std::modf(d, &tmp) != 0) throwException(Not_Integer);
-            val = signedCheck<T>(std::floor(d));
+            if (std::modf(d, &tmp) != 0)
+            {
+                error(ErrorCode::TypeMismatch, Not_Integer);
+                return;
+            }
+            assignChecked(val, std::floor(d));
         }
         else
         {
-            throwException(Not_Integer);
+            error(ErrorCode::TypeMismatch, Not_Integer);
         }
     }
 
@@ -121,24 +351,34 @@ struct JsonDeserializer
     void readFloat(T& val)
     {
         auto jval = r();
+        if (failed()) return;
         if (jval.get_type() == sajson::TYPE_INTEGER) val = T(jval.get_integer_value());
         else if (jval.get_type() == sajson::TYPE_DOUBLE) val = T(jval.get_double_value());
-        else throwException("not a number");
+        else error(ErrorCode::TypeMismatch, "not a number");
     }
 
     template <typename S>
     void readString(S& val)
     {
         auto jval = r();
-        if (jval.get_type() != sajson::TYPE_STRING) throwException("not a string");
-        val = {jval.as_cstring(), jval.get_string_length()};
+        if (failed()) return;
+        if (jval.get_type() != sajson::TYPE_STRING)
+        {
+            error(ErrorCode::TypeMismatch, "not a string");
+            return;
+        }
+        // assign, so that strings reuse their capacity
+        if constexpr (std::is_same_v<S, std::string_view>) val = {jval.as_cstring(), jval.get_string_length()};
+        else val.assign(jval.as_cstring(), jval.get_string_length());
     }
 
     void advance()
     {
+        if (failed()) return;
+
         if (stack.empty())
         {
-            current = {document.get_root(), "root", 0};
+            current = root();
             return;
         }
 
@@ -150,14 +390,15 @@ struct JsonDeserializer
         {
             // "hacky" adjust current so that the exception stack printer does something nice
             current.key = {};
-            current.index = int(top.value.sjvalue.get_length());
-            throwException(Out_of_Range);
+            current.index = top.value.sjvalue.get_length();
+            error(ErrorCode::OutOfRange, Out_of_Range);
+            return;
         }
 
         current = *top.pending;
         auto nextIndex = top.pending->index + 1;
 
-        if (int(top.value.sjvalue.get_length()) <= nextIndex)
+        if (top.value.sjvalue.get_length() <= nextIndex)
         {
             top.pending.reset();
             return;
@@ -187,6 +428,8 @@ struct JsonDeserializer
 
     bool tryLoadKey(std::string_view key)
     {
+        if (failed()) return false;
+
         HUSE_ASSERT_INTERNAL(!stack.empty());
 
         auto& top = stack.back();
@@ -203,7 +446,34 @@ struct JsonDeserializer
         auto& pending = top.pending.emplace();
         pending.sjvalue = top.value.sjvalue.get_object_value(k);
         pending.key = key;
-        pending.index = int(k);
+        pending.index = k;
+        return true;
+    }
+
+    bool tryLoadKeyHinted(std::string_view key, size_t& hint)
+    {
+        if (failed()) return false;
+
+        HUSE_ASSERT_INTERNAL(!stack.empty());
+
+        auto& top = stack.back();
+        auto& obj = top.value.sjvalue;
+
+        if (hint < obj.get_length())
+        {
+            auto k = obj.get_object_key(hint);
+            if (std::string_view(k.data(), k.length()) == key)
+            {
+                auto& pending = top.pending.emplace();
+                pending.sjvalue = obj.get_object_value(hint);
+                pending.key = {k.data(), k.length()};
+                pending.index = hint;
+                return true;
+            }
+        }
+
+        if (!tryLoadKey(key)) return false;
+        hint = top.pending->index;
         return true;
     }
 
@@ -211,14 +481,16 @@ struct JsonDeserializer
     {
         if (!tryLoadKey(key))
         {
+            if (failed()) return;
             // "hacky" adjust current so that the exception stack printer does something nice
             current.key = key;
-            throwException(Out_of_Range);
+            error(ErrorCode::OutOfRange, Out_of_Range);
         }
     }
 
     bool hasPending() const
     {
+        if (failed()) return false;
         if (stack.empty()) return true; // root is pending
         return !!stack.back().pending;
     }
@@ -227,14 +499,17 @@ struct JsonDeserializer
     {
         auto t = optPendingKey();
         if (t) return *t;
+        if (failed()) return {};
         // "hacky" adjust current so that the exception stack printer does something nice
         current.key = {};
-        current.index = int(stack.back().value.sjvalue.get_length());
-        throwException(Out_of_Range);
+        current.index = stack.back().value.sjvalue.get_length();
+        error(ErrorCode::OutOfRange, Out_of_Range);
+        return {};
     }
 
     std::optional<std::string_view> optPendingKey() const
     {
+        if (failed()) return std::nullopt;
         HUSE_ASSERT_INTERNAL(!stack.empty());
         auto& top = stack.back();
         HUSE_ASSERT_INTERNAL(top.value.sjvalue.get_type() == sajson::TYPE_OBJECT);
@@ -242,8 +517,10 @@ struct JsonDeserializer
         return std::nullopt;
     }
 
-    void loadIndex(int index)
+    void loadIndex(size_t index)
     {
+        if (failed()) return;
+
         HUSE_ASSERT_INTERNAL(!stack.empty());
 
         auto& top = stack.back();
@@ -253,29 +530,34 @@ struct JsonDeserializer
         // optimistic check whether the pending index is the same
         if (top.pending && top.pending->index == index) return;
 
-        if (index >= int(top.value.sjvalue.get_length())) {
+        if (index >= top.value.sjvalue.get_length()) {
             // "hacky" adjust current so that the exception stack printer does something nice
             current.key = {};
             current.index = index;
-            throwException(Out_of_Range);
+            error(ErrorCode::OutOfRange, Out_of_Range);
+            return;
         }
 
         // adjust pending so the next call of advance loads it
         auto& pending = top.pending.emplace();
-        pending.sjvalue = top.value.sjvalue.get_array_element(size_t(index));
+        pending.sjvalue = top.value.sjvalue.get_array_element(index);
         pending.index = index;
     }
 
     void loadCompound(sajson::type target)
     {
         advance();
-        if (current.sjvalue.get_type() != target)
+        if (!failed() && current.sjvalue.get_type() != target)
         {
-            if (target == sajson::TYPE_ARRAY) throwException("not an array");
-            else throwException("not an object");
+            if (target == sajson::TYPE_ARRAY) error(ErrorCode::TypeMismatch, "not an array");
+            else error(ErrorCode::TypeMismatch, "not an object");
         }
 
         auto& top = stack.emplace_back();
+
+        // after an error we still push an (empty) element so that the unload which follows is balanced
+        if (failed()) return;
+
         top.value = current;
 
         // adjust pending so the next call of advance loads it
@@ -298,20 +580,277 @@ struct JsonDeserializer
 
     void unloadCompound()
     {
+        auto& top = stack.back();
+        if (stack.size() > 1)
+        {
+            // if we know where the compound ends, let the parent know too
+            size_t end = npos;
+            if (top.srcEnd != npos) end = skipWs(m_source, top.srcEnd);
+            else if (top.srcBegin != npos && top.value.sjvalue.get_length() == 0) end = skipWs(m_source, top.srcBegin + 1);
+
+            // the furthest known element must be the last one
+            if (end != npos && (m_source[end] == '}' || m_source[end] == ']'))
+            {
+                sourceElementEnd(stack[stack.size() - 2], top.value.index, end + 1);
+            }
+        }
         stack.pop_back();
     }
 
-    int curLength() const
+    // retained source
+
+    // opening bracket of the compound at stack level
+    size_t sourceBegin(size_t level)
+    {
+        auto& elem = stack[level];
+        if (elem.srcBegin == npos)
+        {
+            if (level == 0) elem.srcBegin = rootSource();
+            else elem.srcBegin = sourceValueBegin(level - 1, elem.value.index);
+            elem.cursor = {0, elem.srcBegin + 1};
+        }
+        return elem.srcBegin;
+    }
+
+    // start of the value of a member of an object
+    size_t sourceMemberBegin(const sajson::value& object, size_t index) const
+    {
+        // keys point inside the parsed text at the same offsets as in the source
+        // (objects may be sorted, so the index doesn't correspond to the source order)
+        auto key = object.get_object_key(index);
+        auto pos = size_t(key.data() - object.get_text()) - 1; // opening quote
+        pos = skipWs(m_source, skipString(m_source, pos));
+        HUSE_ASSERT_INTERNAL(m_source[pos] == ':');
+        return skipWs(m_source, pos + 1);
+    }
+
+    // start of the value of the element with this index in the compound at stack level
+    size_t sourceValueBegin(size_t level, size_t index)
+    {
+        auto& elem = stack[level];
+        auto& compound = elem.value.sjvalue;
+
+        if (compound.get_type() == sajson::TYPE_OBJECT)
+        {
+            return sourceMemberBegin(compound, index);
+        }
+
+        sourceBegin(level);
+        auto& c = elem.cursor;
+        if (c.index > index) c = {0, elem.srcBegin + 1}; // rewind
+
+        while (true)
+        {
+            auto pos = skipWs(m_source, c.offset);
+            if (m_source[pos] == ',') pos = skipWs(m_source, pos + 1);
+            if (c.index == index)
+            {
+                c.offset = pos;
+                return pos;
+            }
+            c = {c.index + 1, skipValue(m_source, pos)};
+        }
+    }
+
+    static void sourceElementEnd(StackElement& elem, size_t index, size_t end)
+    {
+        if (elem.srcEnd == npos || elem.srcEnd < end) elem.srcEnd = end;
+        if (elem.value.sjvalue.get_type() == sajson::TYPE_ARRAY) elem.cursor = {index + 1, end};
+    }
+
+    // source of the current value
+    std::string_view currentSource()
+    {
+        size_t begin;
+        if (current.sjvalue.get_type() == sajson::TYPE_STRING)
+        {
+            // strings point inside the parsed text at the same offsets as in the source
+            begin = size_t(current.sjvalue.as_cstring() - current.sjvalue.get_text()) - 1;
+        }
+        else if (stack.empty())
+        {
+            begin = rootSource();
+        }
+        else
+        {
+            begin = sourceValueBegin(stack.size() - 1, current.index);
+        }
+
+        auto end = skipValue(m_source, begin);
+        if (!stack.empty()) sourceElementEnd(stack.back(), current.index, end);
+        return m_source.substr(begin, end - begin);
+    }
+
+    bool hasRawJson() const
+    {
+        return !m_source.empty();
+    }
+
+    // json pointers
+
+    Value root() const
+    {
+        if (m_pointerRoot) return *m_pointerRoot;
+        return {m_rootValue, "root", 0};
+    }
+
+    size_t rootSource() const
+    {
+        if (m_pointerRoot) return m_pointerSource;
+        return skipWs(m_source, 0);
+    }
+
+    // navigate the ast directly and make the value at the pointer the root
+    void loadPointer(const JsonPointer& ptr)
+    {
+        m_pointerRoot.reset();
+        if (ptr.empty()) return;
+
+        HUSE_ASSERT_USAGE(stack.empty(), "json pointers can only be loaded from the root");
+        if (failed()) return;
+
+        m_pointerText = ptr.text();
+
+        auto v = m_rootValue;
+        size_t src = hasRawJson() ? skipWs(m_source, 0) : npos;
+        size_t index = 0;
+        for (auto& seg : ptr)
+        {
+            auto len = v.get_length();
+            auto t = v.get_type();
+            if (t == sajson::TYPE_OBJECT)
+            {
+                index = v.find_object_key(sajson::string(seg.key.data(), seg.key.length()));
+            }
+            else if (t == sajson::TYPE_ARRAY)
+            {
+                index = seg.index;
+            }
+            else
+            {
+                index = npos;
+            }
+
+            if (index == npos || index >= len)
+            {
+                // "hacky" adjust current so that the exception stack printer does something nice
+                current = {v, m_pointerText, 0};
+                error(ErrorCode::OutOfRange, Out_of_Range);
+                return;
+            }
+
+            if (t == sajson::TYPE_OBJECT)
+            {
+                if (src != npos) src = sourceMemberBegin(v, index);
+                v = v.get_object_value(index);
+            }
+            else
+            {
+                if (src != npos)
+                {
+                    src = skipWs(m_source, src + 1);
+                    for (size_t i = 0; i < index; ++i)
+                    {
+                        src = skipWs(m_source, skipValue(m_source, src)); // at ','
+                        src = skipWs(m_source, src + 1);
+                    }
+                }
+                v = v.get_array_element(index);
+            }
+        }
+
+        m_pointerRoot = Value{v, m_pointerText, index};
+        m_pointerSource = src;
+    }
+
+    // only the top frame changes while reading its elements
+    // the position caches in it (source offsets and cursor) remain valid, so they're not restored
+    struct Bookmark
+    {
+        size_t depth;
+        const size_t* compound; // identifies the top frame, null at the root
+        std::optional<Value> pending;
+        Value current;
+    };
+
+    const size_t* topCompound() const
+    {
+        return stack.empty() ? nullptr : stack.back().value.sjvalue._internal_get_payload();
+    }
+
+    DeserializerBookmark bookmark() const
+    {
+        Bookmark bm = {stack.size(), topCompound(), {}, current};
+        if (!stack.empty()) bm.pending = stack.back().pending;
+        return {this, bm};
+    }
+
+    DocumentRef documentRef()
+    {
+        return m_shared ? m_shared->buffers.share() : buffers.share();
+    }
+
+    std::shared_ptr<SharedDocument> shareDocument()
+    {
+        if (!m_shared)
+        {
+            // share the text first, so that shared documents are never modified
+            buffers.share();
+            m_shared = std::make_shared<SharedDocument>(std::move(buffers), std::move(document));
+        }
+        return m_shared;
+    }
+
+    DetachedValue detach()
     {
+        advance();
+        if (failed()) return {};
+        auto source = hasRawJson() ? currentSource() : std::string_view{};
+        auto& v = current.sjvalue;
+        return DetachedValue(makeDetached, shareDocument(), v._internal_get_payload(), v._internal_get_tag(), source);
+    }
+
+    static Deserializer makeDetached(const DetachedValue& dv);
+
+    void restore(const DeserializerBookmark& b)
+    {
+        // a compound is identified by its place in the ast, so this also checks the ancestors
+        if (b.owner() != this
+            || b.state<Bookmark>().depth != stack.size()
+            || b.state<Bookmark>().compound != topCompound())
+        {
+            error(ErrorCode::OutOfRange, "bookmark of a different node");
+            return;
+        }
+        auto& bm = b.state<Bookmark>();
+        if (!stack.empty()) stack.back().pending = bm.pending;
+        current = bm.current;
+    }
+
+    std::string_view loadRawJson()
+    {
+        if (!hasRawJson())
+        {
+            error(ErrorCode::Unsupported, "source is not retained");
+            return {};
+        }
+        advance();
+        if (failed()) return {};
+        return currentSource();
+    }
+
+    size_t curLength() const
+    {
+        if (failed()) return 0;
         if (stack.empty()) return 1;
-        return int(stack.back().value.sjvalue.get_length());
+        return stack.back().value.sjvalue.get_length();
     }
 
     static Type fromSajsonType(sajson::type t)
     {
         switch (t)
         {
-        case sajson::TYPE_INTEGER: return {Type::Integer};
+        case sajson::TYPE_INTEGER: return {Type::SignedInteger};
         case sajson::TYPE_DOUBLE:  return {Type::Float};
         case sajson::TYPE_NULL:    return {Type::Null};
         case sajson::TYPE_FALSE:   return {Type::False};
@@ -327,7 +866,8 @@ struct JsonDeserializer
 
     Type pendingType() const
     {
-        if (stack.empty()) return fromSajsonType(document.get_root().get_type());
+        if (failed()) return {Type::Null};
+        if (stack.empty()) return fromSajsonType(root().sjvalue.get_type());
 
         auto& top = stack.back();
         HUSE_ASSERT_INTERNAL(top.pending);
@@ -335,37 +875,32 @@ struct JsonDeserializer
         return fromSajsonType(top.pending->sjvalue.get_type());
     }
 
-    [[noreturn]] void throwException(const std::string_view msg) const
+    // exception with the current path
+    // the text is formatted by the exception when needed
+    DeserializerException exception(ErrorCode code, const std::string_view msg) const
     {
-        std::ostringstream sout;
-
-        if (!stack.empty())
+        DeserializerException ret(code, std::string(msg));
+        for (auto& elem : stack)
         {
-            auto i = stack.begin();
-            sout << i->value.key; // don't wrap root in quotes
-
-            auto printStackItem = [&sout](const Value& val) {
-                sout << '.';
-                if (val.key.empty()) sout << '[' << val.index << ']';
-                else sout << '"' << val.key << '"';
-            };
-
-            for (++i; i!=stack.end(); ++i)
-            {
-                printStackItem(i->value);
-            }
-            printStackItem(current);
-        }
-        else
-        {
-            // certainly this is root
-            sout << current.key;
+            ret.appendPath(elem.value.key, elem.value.index);
         }
+        ret.appendPath(current.key, current.index);
+        return ret;
+    }
+
+    [[noreturn]] void throwException(ErrorCode code, const std::string_view msg) const
+    {
+        throw exception(code, msg);
+    }
 
-        sout << " : " << msg;
-        throw DeserializerException(sout.str());
+    ErrorCode errorCode() const
+    {
+        if (!m_error) return ErrorCode::None;
+        return m_error->code();
     }
 
+    const std::shared_ptr<const DeserializerException>& error() const { return m_error; }
+
     std::istream& loadStringStream()
     {
         std::string_view cur;
@@ -383,9 +918,10 @@ struct JsonDeserializer
 
     void husePolyDeserialize(bool& val) {
         auto t = r().get_type();
+        if (failed()) return;
         if (t == sajson::TYPE_TRUE) val = true;
         else if (t == sajson::TYPE_FALSE) val = false;
-        else throwException("not a boolean");
+        else error(ErrorCode::TypeMismatch, "not a boolean");
     }
     void husePolyDeserialize(short& val) {
         readInt(val);
@@ -455,27 +991,215 @@ DYNAMIX_DEFINE_MIXIN(Domain, JsonDeserializer)
     .implements_by<curLength_msg>([](const JsonDeserializer* d) { return d->curLength(); })
     .implements_by<loadKey_msg>([](JsonDeserializer* d, std::string_view key) { d->loadKey(key); })
     .implements_by<tryLoadKey_msg>([](JsonDeserializer* d, std::string_view key) { return d->tryLoadKey(key); })
-    .implements_by<loadIndex_msg>([](JsonDeserializer* d, int index) { d->loadIndex(index); })
+    .implements_by<tryLoadKeyHinted_msg>([](JsonDeserializer* d, std::string_view key, size_t& hint) { return d->tryLoadKeyHinted(key, hint); })
+    .implements_by<loadIndex_msg>([](JsonDeserializer* d, size_t index) { d->loadIndex(index); })
     .implements_by<hasPending_msg>([](const JsonDeserializer* d) { return d->hasPending(); })
     .implements_by<pendingType_msg>([](const JsonDeserializer* d) { return d->pendingType(); })
     .implements_by<pendingKey_msg>([](const JsonDeserializer* d) { return const_cast<JsonDeserializer*>(d)->pendingKey(); })
     .implements_by<optPendingKey_msg>([](const JsonDeserializer* d) { return d->optPendingKey(); })
-    .implements_by<throwDeserializerException_msg>([](const JsonDeserializer* d, const std::string& msg) { d->throwException(msg); })
+    .implements_by<hasRawJson_msg>([](const JsonDeserializer* d) { return d->hasRawJson(); })
+    .implements_by<loadRawJson_msg>([](JsonDeserializer* d) { return d->loadRawJson(); })
+    .implements_by<loadPointer_msg>([](JsonDeserializer* d, const JsonPointer& ptr) { d->loadPointer(ptr); })
+    .implements_by<bookmark_msg>([](const JsonDeserializer* d) { return d->bookmark(); })
+    .implements_by<restore_msg>([](JsonDeserializer* d, const DeserializerBookmark& b) { d->restore(b); })
+    .implements_by<documentRef_msg>([](JsonDeserializer* d) { return d->documentRef(); })
+    .implements_by<detach_msg>([](JsonDeserializer* d) { return d->detach(); })
+    .implements_by<errorCode_msg>([](const JsonDeserializer* d) { return d->errorCode(); })
+    .implements_by<error_msg>([](const JsonDeserializer* d) { return d->error(); })
+    .implements_by<throwDeserializerException_msg>([](const JsonDeserializer* d, const std::string& msg) { d->throwException(ErrorCode::User, msg); })
 ;
 
-Deserializer Make_Deserializer(std::string_view str) {
+struct Projection::Node final : public sajson::projection
+{
+    bool all = false;
+
+    struct Child
+    {
+        std::string key;
+        size_t index; // key as an array index or npos
+        std::unique_ptr<Node> node;
+    };
+    std::vector<Child> children;
+    std::unique_ptr<Node> any; // "*"
+
+    size_t maxDepth = 1;
+
+    Node& child(const std::string& key, size_t index)
+    {
+        for (auto& c : children)
+        {
+            if (c.key == key) return *c.node;
+        }
+        auto& c = children.emplace_back(Child{key, index, std::make_unique<Node>()});
+        return *c.node;
+    }
+
+    void selectAll()
+    {
+        all = true;
+        children.clear();
+        any.reset();
+    }
+
+    static selection result(const Node& n, const projection*& sub)
+    {
+        if (n.all) return select_all;
+        sub = &n;
+        return select_some;
+    }
+
+    virtual selection select_key(const char* key, size_t length, const projection*& sub) const override
+    {
+        std::string_view k(key, length);
+        for (auto& c : children)
+        {
+            if (c.key == k) return result(*c.node, sub);
+        }
+        if (any) return result(*any, sub);
+        return select_none;
+    }
+
+    virtual selection select_index(size_t index, const projection*& sub) const override
+    {
+        for (auto& c : children)
+        {
+            if (c.index == index) return result(*c.node, sub);
+        }
+        if (any) return result(*any, sub);
+        return select_none;
+    }
+
+    virtual size_t depth() const override
+    {
+        return maxDepth;
+    }
+
+    void merge(const Node& src)
+    {
+        if (all) return;
+        if (src.all)
+        {
+            selectAll();
+            return;
+        }
+        for (auto& c : src.children)
+        {
+            child(c.key, c.index).merge(*c.node);
+        }
+        if (src.any)
+        {
+            if (!any) any = std::make_unique<Node>();
+            any->merge(*src.any);
+        }
+    }
+
+    // add the wildcards to the named children, so selection can stop at the first match
+    void finalize()
+    {
+        maxDepth = 1;
+        for (auto& c : children)
+        {
+            if (any) c.node->merge(*any);
+            c.node->finalize();
+            maxDepth = std::max(maxDepth, c.node->maxDepth + 1);
+        }
+        if (any)
+        {
+            any->finalize();
+            maxDepth = std::max(maxDepth, any->maxDepth + 1);
+        }
+    }
+};
+
+Projection::Projection(const std::vector<std::string_view>& paths)
+    : m_root(std::make_unique<Node>())
+{
+    for (auto path : paths)
+    {
+        JsonPointer pointer(path);
+
+        Node* n = m_root.get();
+        for (auto& seg : pointer)
+        {
+            if (n->all) break;
+            if (seg.key == "*")
+            {
+                if (!n->any) n->any = std::make_unique<Node>();
+                n = n->any.get();
+            }
+            else
+            {
+                n = &n->child(seg.key, seg.index);
+            }
+        }
+        n->selectAll();
+    }
+    m_root->finalize();
+}
+
+Projection::~Projection() = default;
+
+namespace
+{
+const sajson::projection* rootProjection(const DeserializerOptions& opts)
+{
+    if (!opts.projection) return nullptr;
+    auto root = opts.projection->_root();
+    if (root->all) return nullptr;
+    return root;
+}
+
+template <typename String>
+sajson::document parse(const String& str, const DeserializerOptions& opts, DocumentBuffers& buffers)
+{
+    auto proj = rootProjection(opts);
+    if (proj)
+    {
+        // the ast is proportional to the selected data, so don't allocate it upfront
+        return sajson::parse(sajson::dynamic_allocation(), str, proj);
+    }
+    if (buffers.resource)
+    {
+        auto ast = buffers.allocateAst(str.length());
+        return sajson::parse(sajson::single_allocation(ast, buffers.astSize), str);
+    }
+    return sajson::parse(sajson::single_allocation(), str);
+}
+}
+
+Deserializer Make_Deserializer(std::string_view str, const DeserializerOptions& opts) {
+    DocumentBuffers buffers(opts.memoryResource);
+    // parse our own copy instead of letting sajson make one, so that it can be shared
+    auto doc = parse(sajson::mutable_string_view(str.length(), buffers.copyText(str)), opts, buffers);
     Deserializer ret;
-    mutate(ret, dynamix::add<JsonDeserializer>(sajson::parse(
-        sajson::single_allocation(),
-        sajson::string(str.data(), str.length()))));
+    ret.setMemoryResource(opts.memoryResource);
+    mutate(ret, dynamix::add<JsonDeserializer>(std::move(buffers), std::move(doc),
+        opts, opts.retainSource ? str : std::string_view{}));
     return ret;
 }
-Deserializer Make_Deserializer(char* str, size_t len) {
+Deserializer Make_Deserializer(char* str, size_t len, const DeserializerOptions& opts) {
+    DocumentBuffers buffers(opts.memoryResource);
+    auto doc = parse(sajson::mutable_string_view(len == size_t(-1) ? strlen(str) : len, str), opts, buffers);
     Deserializer ret;
-    mutate(ret, dynamix::add<JsonDeserializer>(sajson::parse(
-        sajson::single_allocation(),
-        sajson::mutable_string_view(len == size_t(-1) ? strlen(str) : len, str))));
+    ret.setMemoryResource(opts.memoryResource);
+    mutate(ret, dynamix::add<JsonDeserializer>(std::move(buffers), std::move(doc), opts));
     return ret;
 }
 
+Deserializer JsonDeserializer::makeDetached(const DetachedValue& dv) {
+    auto shared = std::static_pointer_cast<SharedDocument>(std::const_pointer_cast<void>(dv.ref()));
+    auto text = shared->document.get_root().get_text();
+    auto root = sajson::value::_internal_make(uint8_t(dv.tag()), static_cast<const size_t*>(dv.value()), text);
+    Deserializer ret;
+    ret.setMemoryResource(shared->buffers.resource);
+    mutate(ret, dynamix::add<JsonDeserializer>(std::move(shared), root));
+    return ret;
+}
+
+void transcode(std::string_view json, SerializerNode& out) {
+    auto d = Make_Deserializer(json);
+    auto in = d.root();
+    huse::transcode(in, out);
+}
+
 }
@@ -4,9 +4,13 @@
 #pragma once
 #include "../API.h"
 #include "../DeserializerObj.hpp"
+#include "../Fwd.hpp"
 #include <dynamix/declare_mixin.hpp>
 #include <string_view>
 #include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
 // #include <dynamix/common_mixin_init.hpp>
 
 namespace huse::json {
@@ -19,6 +23,54 @@ DYNAMIX_DECLARE_EXPORTED_MIXIN(HUSE_API, struct JsonDeserializer);
 //    virtual void do_init(const dynamix::mixin_info&, dynamix::mixin_index_t, dynamix::byte_t* new_mixin) final override;
 //};
 
-HUSE_API Deserializer Make_Deserializer(std::string_view str);
-HUSE_API Deserializer Make_Deserializer(char* mutableString, size_t len = size_t(-1));
+// paths to keep when parsing a document
+// paths are json pointers (RFC 6901), where the segment "*" matches any key or index
+// everything which is not on or under a path is validated by the parser, but not stored:
+// skipped object members are missing and skipped array elements are null
+// a projection can be reused for many documents
+class HUSE_API Projection
+{
+public:
+    explicit Projection(const std::vector<std::string_view>& paths);
+    ~Projection();
+
+    Projection(const Projection&) = delete;
+    Projection& operator=(const Projection&) = delete;
+
+    struct Node;
+    const Node* _root() const { return m_root.get(); }
+
+private:
+    std::unique_ptr<Node> m_root;
+};
+
+struct DeserializerOptions
+{
+    // when false, the first error (including a parse error) is recorded in the deserializer
+    // instead of being thrown and all subsequent reads are no-ops
+    // check it with Deserializer::tryVal or errorCode_msg
+    bool throwOnError = true;
+
+    // keep a view of the unmodified input, so that the source of values can be read verbatim
+    // (used by transcode to copy numbers and escaped strings to a json serializer as they are)
+    // the input must outlive the deserializer
+    // only applies to std::string_view input, as mutable strings are modified by the parser
+    bool retainSource = false;
+
+    // only store the selected parts of the document (null to store everything)
+    // it only needs to be alive while the deserializer is being created
+    const Projection* projection = nullptr;
+
+    // memory for the parsed document (a copy of immutable input and the ast, unless there is
+    // a projection) which is also attached to the deserializer (see Deserializer::setMemoryResource)
+    // it must outlive the deserializer
+    std::pmr::memory_resource* memoryResource = nullptr;
+};
+
+HUSE_API Deserializer Make_Deserializer(std::string_view str, const DeserializerOptions& opts = {});
+HUSE_API Deserializer Make_Deserializer(char* mutableString, size_t len = size_t(-1), const DeserializerOptions& opts = {});
+
+// parse json and write it to a node of any serializer
+// for backends which don't produce json, but still accept raw json (see writeRawJson_msg)
+HUSE_API void transcode(std::string_view json, SerializerNode& out);
 }
@@ -11,16 +11,34 @@
 #include "../PolyTraits.hpp"
 #include "../impl/Assert.hpp"
 
+#include "_sajson/sajson.hpp"
+
 #include <msstl/charconv.hpp>
 
 #include <dynamix/define_mixin.hpp>
 #include <dynamix/mutate.hpp>
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <exception>
 #include <new>
 #include <ostream>
+#include <string>
 #include <type_traits>
+#include <vector>
+
+// HUSE_VALIDATE_RAW_JSON
+// when enabled, raw json written through writeRawJson_msg is parsed and an exception is thrown if it's not
+// a single valid json value
+// enabled by default in debug builds
+#if !defined(HUSE_VALIDATE_RAW_JSON)
+#   if defined(NDEBUG)
+#       define HUSE_VALIDATE_RAW_JSON 0
+#   else
+#       define HUSE_VALIDATE_RAW_JSON 1
+#   endif
+#endif
 
 namespace huse::json
 {
@@ -79,32 +97,56 @@ void writeEscapedUTF8StringToStreambuf(std::streambuf& buf, std::string_view str
 
 struct JsonRedirectStreambuf : public std::streambuf
 {
-    JsonRedirectStreambuf(std::streambuf& redirectTarget) : m_redirectTarget(redirectTarget) {}
+    // characters are staged in a local buffer and escaped in bulk when it's full or on sync
+    // this way operator<< on small values doesn't cost a virtual call per character
+    static constexpr std::streamsize Buffer_Size = 512;
 
-    int_type overflow(int_type ch) override
+    JsonRedirectStreambuf(std::streambuf& redirectTarget) : m_redirectTarget(&redirectTarget)
     {
-        auto esc = escapeUtf8Byte(char(ch));
-        if (esc)
-        {
-            m_redirectTarget.sputn(esc->data(), esc->length());
-        }
-        else
-        {
-            m_redirectTarget.sputc(char(ch));
-        }
+        setp(m_buffer, m_buffer + Buffer_Size);
+    }
+
+    void flushStaged()
+    {
+        if (pptr() == pbase()) return; // nothing to flush
+        writeEscapedUTF8StringToStreambuf(*m_redirectTarget, std::string_view(pbase(), pptr() - pbase()));
+        setp(m_buffer, m_buffer + Buffer_Size);
+    }
 
+    int_type overflow(int_type ch) override
+    {
+        flushStaged();
+        if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
         return ch;
     }
 
     std::streamsize xsputn(const char_type* s, std::streamsize num) override
     {
-        writeEscapedUTF8StringToStreambuf(m_redirectTarget, std::string_view(s, num));
+        if (num <= epptr() - pptr())
+        {
+            // fits in the staging area
+            std::memcpy(pptr(), s, size_t(num));
+            pbump(int(num));
+            return num;
+        }
+
+        // too big: write what we have and escape the input directly
+        flushStaged();
+        writeEscapedUTF8StringToStreambuf(*m_redirectTarget, std::string_view(s, size_t(num)));
         return num;
     }
 
+    int sync() override
+    {
+        flushStaged();
+        return 0;
+    }
+
     [[noreturn]] void throwSeekException()
     {
-        throw SerializerException("Seek is not supported by JSON string streams");
+        throw SerializerException(ErrorCode::Unsupported, "Seek is not supported by JSON string streams");
     }
 
     [[noreturn]] pos_type seekpos(pos_type, std::ios_base::openmode) override
@@ -117,26 +159,193 @@ struct JsonRedirectStreambuf : public std::streambuf
         throwSeekException();
     }
 
-    std::streambuf& m_redirectTarget;
+    std::streambuf* m_redirectTarget;
+    char m_buffer[Buffer_Size];
 };
 
+// created once per serializer and reused for all string streams
 struct JsonOStream
 {
-    JsonOStream(std::ostream& rt)
-        : streambuf(*rt.rdbuf())
+    JsonOStream(std::streambuf& target)
+        : streambuf(target)
         , stream(&streambuf)
     {}
 
+    // restore the state of a freshly constructed stream
+    // so that manipulators from a previous use don't leak into the next one
+    void reset(std::streambuf& target)
+    {
+        streambuf.m_redirectTarget = &target;
+        stream.clear();
+        stream.flags(std::ios_base::skipws | std::ios_base::dec);
+        stream.width(0);
+        stream.precision(6);
+        stream.fill(' ');
+    }
+
     JsonRedirectStreambuf streambuf;
     std::ostream stream;
 };
+
+// growable in-memory output
+// positions in it are offsets, so they survive growth
+struct ArenaStreambuf : public std::streambuf
+{
+    ArenaStreambuf() { setp(m_data.data(), m_data.data()); }
+
+    size_t size() const { return size_t(pptr() - pbase()); }
+    void clear() { truncate(0); }
+    const char* data() const { return pbase(); }
+
+    void truncate(size_t size)
+    {
+        HUSE_ASSERT_INTERNAL(size <= this->size());
+        setp(m_data.data(), m_data.data() + m_data.size());
+        advance(size);
+    }
+
+    void grow(size_t extra)
+    {
+        auto size = this->size();
+        m_data.resize(std::max(m_data.size() * 2, size + extra + 256));
+        setp(m_data.data(), m_data.data() + m_data.size());
+        advance(size);
+    }
+
+    // pbump takes an int
+    void advance(size_t n)
+    {
+        while (n)
+        {
+            auto step = std::min(n, size_t(0x40000000));
+            pbump(int(step));
+            n -= step;
+        }
+    }
+
+    int_type overflow(int_type ch) override
+    {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+        grow(1);
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+        return ch;
+    }
+
+    std::streamsize xsputn(const char_type* s, std::streamsize num) override
+    {
+        if (num > epptr() - pptr()) grow(size_t(num));
+        std::memcpy(pptr(), s, size_t(num));
+        advance(size_t(num));
+        return num;
+    }
+
+    std::string m_data;
+};
+
+// compare utf-8 strings by their utf-16 code units (RFC 8785)
+// utf-8 byte order is code point order, which only differs from utf-16 order when
+// a character from U+E000-U+FFFF is compared with one above U+FFFF (encoded as surrogates)
+bool utf16Less(std::string_view a, std::string_view b)
+{
+    const auto len = std::min(a.size(), b.size());
+    size_t i = 0;
+    while (i < len && a[i] == b[i]) ++i;
+    if (i == len) return a.size() < b.size();
+
+    // find the start of the differing characters
+    while (i > 0 && (uint8_t(a[i]) & 0xC0) == 0x80) --i;
+
+    auto decode = [](std::string_view str, size_t i) -> uint32_t {
+        auto c = uint8_t(str[i]);
+        int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+        uint32_t cp = extra ? c & (0x3F >> extra) : c;
+        for (int e = 1; e <= extra && i + e < str.size(); ++e) cp = (cp << 6) | (uint8_t(str[i + e]) & 0x3F);
+        return cp;
+    };
+    auto firstUnit = [](uint32_t cp) -> uint32_t {
+        return cp < 0x10000 ? cp : 0xD800 + ((cp - 0x10000) >> 10);
+    };
+
+    auto ca = decode(a, i), cb = decode(b, i);
+    auto ua = firstUnit(ca), ub = firstUnit(cb);
+    if (ua != ub) return ua < ub;
+    return ca < cb; // same high surrogate
+}
+
+// shortest round-trip digits formatted as ECMAScript's Number.prototype.toString (RFC 8785)
+template <typename T>
+std::string_view formatCanonicalNumber(char (&out)[32], T val)
+{
+    if (val == 0) return "0"; // also -0
+
+    char sci[32];
+    auto result = msstl::to_chars(sci, sci + sizeof(sci), val, msstl::chars_format::scientific);
+    const char* p = sci;
+
+    char* o = out;
+    if (*p == '-')
+    {
+        *o++ = '-';
+        ++p;
+    }
+
+    char digits[20];
+    int k = 0;
+    for (; *p != 'e'; ++p)
+    {
+        if (*p != '.') digits[k++] = *p;
+    }
+    ++p; // e
+    bool negExp = *p++ == '-';
+    int exp = 0;
+    for (; p != result.ptr; ++p) exp = exp * 10 + (*p - '0');
+    if (negExp) exp = -exp;
+
+    const int n = exp + 1; // position of the decimal point
+    if (k <= n && n <= 21)
+    {
+        o = std::copy(digits, digits + k, o);
+        o = std::fill_n(o, n - k, '0');
+    }
+    else if (0 < n && n <= 21)
+    {
+        o = std::copy(digits, digits + n, o);
+        *o++ = '.';
+        o = std::copy(digits + n, digits + k, o);
+    }
+    else if (-6 < n && n <= 0)
+    {
+        *o++ = '0';
+        *o++ = '.';
+        o = std::fill_n(o, -n, '0');
+        o = std::copy(digits, digits + k, o);
+    }
+    else
+    {
+        *o++ = digits[0];
+        if (k > 1)
+        {
+            *o++ = '.';
+            o = std::copy(digits + 1, digits + k, o);
+        }
+        *o++ = 'e';
+        *o++ = n - 1 < 0 ? '-' : '+';
+        auto r = msstl::to_chars(o, out + sizeof(out), n - 1 < 0 ? 1 - n : n - 1);
+        o = r.ptr;
+    }
+
+    return std::string_view(out, size_t(o - out));
+}
 }
 
 struct JsonSerializer
 {
-    JsonSerializer(std::ostream& out, bool pretty)
+    JsonSerializer(std::ostream& out, const SerializerOptions& opts)
         : m_out(out)
-        , m_pretty(pretty)
+        , m_target(out.rdbuf())
+        , m_pretty(opts.pretty && !opts.canonical)
+        , m_canonical(opts.canonical)
     {}
 
     ~JsonSerializer() {
@@ -144,11 +353,79 @@ struct JsonSerializer
         HUSE_ASSERT_INTERNAL(m_depth == 0);
     }
     std::ostream& m_out;
+    std::streambuf* m_target; // m_out's buffer or the arena of buffered object members
 
     void writeRawJson(std::string_view json)
     {
         prepareWriteVal();
-        m_out.rdbuf()->sputn(json.data(), json.size());
+        m_target->sputn(json.data(), json.size());
+    }
+
+    void writeCheckedRawJson(std::string_view json)
+    {
+        if (m_canonical)
+        {
+            writeCanonicalRawJson(json);
+            return;
+        }
+#if HUSE_VALIDATE_RAW_JSON
+        // sajson only accepts arrays and objects as root, so wrap the value
+        std::string wrapped;
+        wrapped.reserve(json.size() + 2);
+        wrapped += '[';
+        wrapped += json;
+        wrapped += ']';
+        auto doc = sajson::parse(sajson::single_allocation(), sajson::mutable_string_view(wrapped.size(), wrapped.data()));
+        if (!doc.is_valid() || doc.get_root().get_length() != 1)
+        {
+            throwException(ErrorCode::Syntax, "Invalid raw json");
+        }
+#endif
+        writeRawJson(json);
+    }
+
+    // raw json may not be canonical, so write it value by value
+    void writeCanonicalRawJson(std::string_view json)
+    {
+        std::string wrapped;
+        wrapped.reserve(json.size() + 2);
+        wrapped += '[';
+        wrapped += json;
+        wrapped += ']';
+        auto doc = sajson::parse(sajson::dynamic_allocation(), sajson::mutable_string_view(wrapped.size(), wrapped.data()));
+        if (!doc.is_valid() || doc.get_root().get_length() != 1)
+        {
+            throwException(ErrorCode::Syntax, "Invalid raw json");
+        }
+        writeSajsonValue(doc.get_root().get_array_element(0));
+    }
+
+    void writeSajsonValue(const sajson::value& val)
+    {
+        switch (val.get_type())
+        {
+        case sajson::TYPE_INTEGER: husePolySerialize(val.get_integer_value()); break;
+        case sajson::TYPE_DOUBLE: husePolySerialize(val.get_double_value()); break;
+        case sajson::TYPE_NULL: husePolySerialize(nullptr); break;
+        case sajson::TYPE_FALSE: husePolySerialize(false); break;
+        case sajson::TYPE_TRUE: husePolySerialize(true); break;
+        case sajson::TYPE_STRING: husePolySerialize(std::string_view(val.as_cstring(), val.get_string_length())); break;
+        case sajson::TYPE_ARRAY:
+            openArray();
+            for (size_t i = 0; i < val.get_length(); ++i) writeSajsonValue(val.get_array_element(i));
+            closeArray();
+            break;
+        case sajson::TYPE_OBJECT:
+            openObject();
+            for (size_t i = 0; i < val.get_length(); ++i)
+            {
+                auto key = val.get_object_key(i);
+                pushKey(std::string_view(key.data(), key.length()));
+                writeSajsonValue(val.get_object_value(i));
+            }
+            closeObject();
+            break;
+        }
     }
 
     template <typename T>
@@ -156,7 +433,7 @@ struct JsonSerializer
     {
         prepareWriteVal();
 
-        auto& out = *m_out.rdbuf();
+        auto& out = *m_target;
 
         using Unsigned = std::make_unsigned_t<T>;
         Unsigned uvalue = Unsigned(n);
@@ -211,7 +488,7 @@ struct JsonSerializer
             }
             else
             {
-                throwException(std::string(IntegerTooBig));
+                throwException(ErrorCode::NumberRange, std::string(IntegerTooBig));
             }
         }
         else
@@ -222,7 +499,7 @@ struct JsonSerializer
             }
             else
             {
-                throwException(std::string(IntegerTooBig));
+                throwException(ErrorCode::NumberRange, std::string(IntegerTooBig));
             }
         }
 
@@ -237,7 +514,12 @@ struct JsonSerializer
     template <typename T>
     void writeFloatValue(T val)
     {
-        if (std::isfinite(val))
+        if (std::isfinite(val) && m_canonical)
+        {
+            char out[32];
+            writeRawJson(formatCanonicalNumber(out, val));
+        }
+        else if (std::isfinite(val))
         {
             char out[25]; // max length of double
             auto result = msstl::to_chars(out, out + sizeof(out), val);
@@ -245,7 +527,7 @@ struct JsonSerializer
         }
         else
         {
-            throwException("Floating point value is not finite. Not supported by JSON");
+            throwException(ErrorCode::NumberRange, "Floating point value is not finite. Not supported by JSON");
         }
     }
 
@@ -254,7 +536,7 @@ struct JsonSerializer
 
     void writeQuotedEscapedUTF8String(std::string_view str)
     {
-        auto& out = *m_out.rdbuf();
+        auto& out = *m_target;
         out.sputc('"');
         writeEscapedUTF8StringToStreambuf(out, str);
         out.sputc('"');
@@ -280,7 +562,7 @@ struct JsonSerializer
     void open(char o)
     {
         prepareWriteVal();
-        m_out.rdbuf()->sputc(o);
+        m_target->sputc(o);
         m_hasValue = false;
         ++m_depth;
     }
@@ -290,24 +572,131 @@ struct JsonSerializer
         HUSE_ASSERT_INTERNAL(m_depth);
         --m_depth;
         if (m_hasValue) newLine();
-        m_out.rdbuf()->sputc(c);
+        m_target->sputc(c);
         m_hasValue = true;
     }
 
-    void openObject() { open('{'); }
-    void closeObject() { close('}'); }
+    void openObject()
+    {
+        if (!m_canonical) return open('{');
+
+        prepareWriteVal();
+        // members are buffered in the arena and written sorted when the outermost object closes
+        auto& level = m_levels.size() > m_numLevels ? m_levels[m_numLevels] : m_levels.emplace_back();
+        ++m_numLevels;
+        level.begin = m_arena.size();
+        level.keysBegin = m_keys.size();
+        level.members.clear();
+        level.children.clear();
+        m_target = &m_arena;
+        m_hasValue = false;
+        ++m_depth;
+        level.depth = m_depth;
+    }
+
+    void closeObject()
+    {
+        if (!m_canonical) return close('}');
+
+        HUSE_ASSERT_INTERNAL(m_numLevels && m_levels[m_numLevels - 1].depth == m_depth);
+        auto& level = m_levels[m_numLevels - 1];
+        auto& members = level.members;
+
+        const size_t end = m_arena.size();
+        for (size_t i = 0; i < members.size(); ++i)
+        {
+            members[i].end = i + 1 < members.size() ? members[i + 1].begin : end;
+        }
+
+        std::stable_sort(members.begin(), members.end(), [this](const Member& a, const Member& b) {
+            return utf16Less(key(a), key(b));
+        });
+
+        // the object stays in the arena unsorted and is only recorded with its sorted members
+        // so nested objects aren't copied on each level
+        const size_t childBase = m_closedChildren.size();
+        m_closedChildren.insert(m_closedChildren.end(), level.children.begin(), level.children.end());
+        auto& obj = m_closed.emplace_back();
+        obj.begin = level.begin;
+        obj.end = end;
+        obj.membersBegin = m_closedMembers.size();
+        for (auto m : members)
+        {
+            m.childBegin += childBase;
+            m.childEnd += childBase;
+            m_closedMembers.push_back(m);
+        }
+        obj.membersEnd = m_closedMembers.size();
+
+        --m_numLevels;
+        --m_depth;
+        m_hasValue = true;
+        m_keys.resize(level.keysBegin);
+
+        if (m_numLevels)
+        {
+            // a value of the last member of the enclosing object (possibly in arrays)
+            auto& parent = m_levels[m_numLevels - 1];
+            parent.children.push_back(m_closed.size() - 1);
+            parent.members.back().childEnd = parent.children.size();
+        }
+        else
+        {
+            m_target = m_out.rdbuf();
+            writeClosed(*m_target, m_closed.size() - 1);
+            m_arena.truncate(0);
+            m_closed.clear();
+            m_closedMembers.clear();
+            m_closedChildren.clear();
+        }
+    }
+
+    void writeClosed(std::streambuf& out, size_t index) const
+    {
+        auto& obj = m_closed[index];
+        out.sputc('{');
+        for (size_t i = obj.membersBegin; i < obj.membersEnd; ++i)
+        {
+            auto& m = m_closedMembers[i];
+            if (i != obj.membersBegin) out.sputc(',');
+            // the member's bytes with its nested objects replaced by their sorted versions
+            size_t pos = m.begin;
+            for (size_t c = m.childBegin; c < m.childEnd; ++c)
+            {
+                auto& child = m_closed[m_closedChildren[c]];
+                out.sputn(m_arena.data() + pos, std::streamsize(child.begin - pos));
+                writeClosed(out, m_closedChildren[c]);
+                pos = child.end;
+            }
+            out.sputn(m_arena.data() + pos, std::streamsize(m.end - pos));
+        }
+        out.sputc('}');
+    }
+
     void openArray() { open('['); }
     void closeArray() { close(']'); }
 
     void prepareWriteVal()
     {
-        auto& out = *m_out.rdbuf();
-
-        if (m_hasValue)
+        if (m_numLevels && m_levels[m_numLevels - 1].depth == m_depth)
         {
-            out.sputc(',');
+            // member of a canonical object
+            HUSE_ASSERT_INTERNAL(m_pendingKey);
+            auto& level = m_levels[m_numLevels - 1];
+            auto& m = level.members.emplace_back();
+            m.begin = m_arena.size();
+            m.keyBegin = m_keys.size();
+            m.keySize = m_pendingKey->size();
+            m.childBegin = m.childEnd = level.children.size();
+            m_keys += *m_pendingKey;
+        }
+        else if (m_hasValue)
+        {
+            m_target->sputc(',');
         }
 
+        auto& out = *m_target;
+
         newLine();
 
         if (m_pendingKey)
@@ -325,7 +714,7 @@ struct JsonSerializer
         if (!m_pretty) return; // not pretty
         if (m_depth == 0 && !m_hasValue) return; // no new line for initial value
 
-        auto& out = *m_out.rdbuf();
+        auto& out = *m_target;
         out.sputc('\n');
         static constexpr std::string_view indent = "  ";
         for (uint32_t i = 0; i < m_depth; ++i)
@@ -337,23 +726,25 @@ struct JsonSerializer
     std::ostream& openStringStream()
     {
         prepareWriteVal();
-        HUSE_ASSERT_INTERNAL(!m_stringStream);
-        m_out.rdbuf()->sputc('"');
-        m_stringStream = new (&m_stringStreamBuffer) JsonOStream(m_out);
+        HUSE_ASSERT_INTERNAL(!m_stringStreamOpen);
+        m_target->sputc('"');
+        if (m_stringStream) m_stringStream->reset(*m_target);
+        else m_stringStream.emplace(*m_target);
+        m_stringStreamOpen = true;
         return m_stringStream->stream;
     }
 
     void closeStringStream()
     {
-        assert(!!m_stringStream);
-        m_stringStream->~JsonOStream();
-        m_stringStream = nullptr;
-        m_out.rdbuf()->sputc('"');
+        HUSE_ASSERT_INTERNAL(m_stringStreamOpen);
+        m_stringStream->streambuf.flushStaged();
+        m_stringStreamOpen = false;
+        m_target->sputc('"');
     }
 
-    void throwException(const std::string& msg) const
+    [[noreturn]] void throwException(ErrorCode code, const std::string& msg) const
     {
-        throw SerializerException(msg);
+        throw SerializerException(code, msg);
     }
 
     std::optional<std::string_view> m_pendingKey;
@@ -361,8 +752,52 @@ struct JsonSerializer
     const bool m_pretty;
     uint32_t m_depth = 0; // used to indent if pretty
 
-    std::aligned_storage_t<sizeof(JsonOStream), alignof(JsonOStream)> m_stringStreamBuffer;
-    JsonOStream* m_stringStream = nullptr;
+    std::optional<JsonOStream> m_stringStream;
+    bool m_stringStreamOpen = false;
+
+    // canonical mode
+    const bool m_canonical;
+
+    // a buffered member of an object: "key":value in the arena
+    struct Member
+    {
+        size_t begin;
+        size_t end;
+        size_t keyBegin; // unescaped key in m_keys
+        size_t keySize;
+        // the objects in the value (in Level::children while open, in m_closedChildren after)
+        size_t childBegin;
+        size_t childEnd;
+    };
+    std::string_view key(const Member& m) const { return std::string_view(m_keys.data() + m.keyBegin, m.keySize); }
+
+    // an open object
+    struct Level
+    {
+        size_t begin; // of its members in the arena
+        size_t keysBegin;
+        uint32_t depth;
+        std::vector<Member> members;
+        std::vector<size_t> children; // closed nested objects in document order
+    };
+    // levels are reused along with their vectors
+    std::vector<Level> m_levels;
+    size_t m_numLevels = 0;
+
+    // a closed nested object, written when the outermost object closes
+    struct ClosedObject
+    {
+        size_t begin; // of its unsorted members in the arena
+        size_t end;
+        size_t membersBegin; // sorted, in m_closedMembers
+        size_t membersEnd;
+    };
+    std::vector<ClosedObject> m_closed;
+    std::vector<Member> m_closedMembers;
+    std::vector<size_t> m_closedChildren;
+
+    ArenaStreambuf m_arena;
+    std::string m_keys;
 };
 
 DYNAMIX_DEFINE_MIXIN(Domain, JsonSerializer)
@@ -401,8 +836,15 @@ DYNAMIX_DEFINE_MIXIN(Domain, JsonSerializer)
     .implements_by<closeArray_msg>([](JsonSerializer* s) {
         s->closeArray();
     })
+    .implements_by<acceptsRawJson_msg>([](const JsonSerializer* s) {
+        // raw json is canonicalized value by value, so it's not accepted verbatim
+        return !s->m_canonical;
+    })
+    .implements_by<writeRawJson_msg>([](JsonSerializer* s, std::string_view json) {
+        s->writeCheckedRawJson(json);
+    })
     .implements_by<throwSerializerException_msg>([](const JsonSerializer* s, const std::string& str) {
-        s->throwException(str);
+        s->throwException(ErrorCode::User, str);
     })
 ;
 
@@ -411,8 +853,14 @@ DYNAMIX_DEFINE_MIXIN(Domain, JsonSerializer)
 //}
 
 Serializer Make_Serializer(std::ostream& out, bool pretty) {
+    SerializerOptions opts;
+    opts.pretty = pretty;
+    return Make_Serializer(out, opts);
+}
+
+Serializer Make_Serializer(std::ostream& out, const SerializerOptions& opts) {
     Serializer ret;
-    mutate(ret, dynamix::add<JsonSerializer>(out, pretty));
+    mutate(ret, dynamix::add<JsonSerializer>(out, opts));
     return ret;
 }
 
@@ -18,5 +18,22 @@ DYNAMIX_DECLARE_EXPORTED_MIXIN(HUSE_API, struct JsonSerializer);
 //    virtual void do_init(const dynamix::mixin_info&, dynamix::mixin_index_t, dynamix::byte_t* new_mixin) final override;
 //};
 
+struct SerializerOptions
+{
+    // new lines and indentation
+    bool pretty = false;
+
+    // deterministic output (RFC 8785 style) for signing and content addressing:
+    // * object members are sorted by the utf-16 code units of their keys
+    // * floating point numbers are written with their shortest round-trip digits
+    //   in the format of ECMAScript's Number.prototype.toString
+    // * no whitespace (pretty is ignored)
+    // the members of open objects are buffered as serialized fragments (no dom is built)
+    // and written sorted when their object is closed
+    // integers are written as they are and raw json is canonicalized value by value
+    bool canonical = false;
+};
+
 HUSE_API Serializer Make_Serializer(std::ostream& out, bool pretty = false);
+HUSE_API Serializer Make_Serializer(std::ostream& out, const SerializerOptions& opts);
 }
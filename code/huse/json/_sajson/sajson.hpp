@@ -37,6 +37,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <new>
 
 #ifndef SAJSON_NO_STD_STRING
 #include <string> // for convenient access to error messages and string values.
@@ -463,6 +464,10 @@ public:
         , payload{ nullptr }
         , text{ nullptr } {}
 
+    /// Returns the start of the parsed text. String values and object keys
+    /// point inside it at the same offsets as in the original input.
+    const char* get_text() const { return text; }
+
     /// Returns the JSON value's \ref type.
     type get_type() const {
         // As of 2020, current versions of MSVC generate a jump table for this
@@ -676,6 +681,10 @@ public:
 
     /// \cond INTERNAL
     const size_t* _internal_get_payload() const { return payload; }
+    uint8_t _internal_get_tag() const { return static_cast<uint8_t>(value_tag); }
+    static value _internal_make(uint8_t tag_, const size_t* payload_, const char* text_) {
+        return value(static_cast<internal::tag>(tag_), payload_, text_);
+    }
     /// \endcond
 
 private:
@@ -808,6 +817,8 @@ inline const char* get_error_text(error error_code) {
 }
 } // namespace internal
 
+class projection;
+
 /**
  * Represents the result of a JSON parse: either is_valid() and the document
  * contains a root value or parse error information is available.
@@ -971,6 +982,11 @@ private:
     template <typename AllocationStrategy, typename StringType>
     friend document
     parse(const AllocationStrategy& strategy, const StringType& string);
+    template <typename AllocationStrategy, typename StringType>
+    friend document parse(
+        const AllocationStrategy& strategy,
+        const StringType& string,
+        const projection* proj);
     template <typename Allocator>
     friend class parser;
 };
@@ -1571,13 +1587,41 @@ private:
 // I thought about putting parser in the internal namespace but I don't
 // want to indent it further...
 /// \cond INTERNAL
+/// Selects which parts of a document are stored in the AST.
+/// Values which are not selected are validated but skipped. Skipped object
+/// members are omitted and skipped array elements are stored as null, so
+/// the indices of the selected elements are preserved.
+class projection {
+public:
+    enum selection {
+        select_none, // skip the value
+        select_some, // keep the value, but project its children with `sub`
+        select_all, // keep the value and everything in it
+    };
+
+    virtual selection
+    select_key(const char* key, size_t length, const projection*& sub) const = 0;
+    virtual selection
+    select_index(size_t index, const projection*& sub) const = 0;
+
+    /// Maximum number of nested projections (including this one).
+    virtual size_t depth() const = 0;
+
+protected:
+    ~projection() = default;
+};
+
 template <typename Allocator>
 class parser {
 public:
-    parser(const mutable_string_view& msv, Allocator&& allocator_)
+    parser(
+        const mutable_string_view& msv,
+        Allocator&& allocator_,
+        const projection* root_projection_ = nullptr)
         : input(msv)
         , input_end(input.get_data() + input.length())
         , allocator(std::move(allocator_))
+        , root_projection(root_projection_)
         , root_tag(internal::tag::null)
         , error_line(0)
         , error_column(0) {}
@@ -1682,6 +1726,18 @@ private:
             return make_error(p, ERROR_MISSING_ROOT_ELEMENT);
         }
 
+        // projection of the current structure, null if everything is kept
+        const projection* proj = root_projection;
+        // projection of the next value when proj is not null
+        const projection* child_proj = nullptr;
+        // number of open structures inside of the current kept-whole one
+        size_t full_depth = 0;
+        // projections of the partially kept structures which are open
+        projection_stack proj_stack(root_projection);
+        if (SAJSON_UNLIKELY(root_projection && !proj_stack.data)) {
+            return oom(p, "projection stack");
+        }
+
         // current_base is an offset to the first element of the current
         // structure (object or array)
         size_t current_base = stack.get_size();
@@ -1817,6 +1873,22 @@ private:
                 return make_error(p, ERROR_EXPECTED_COLON);
             }
             ++p;
+            if (proj) {
+                auto sel = proj->select_key(
+                    input.get_data() + out[0], out[1] - out[0], child_proj);
+                if (sel == projection::select_none) {
+                    // drop the key and skip the value
+                    stack.reset(stack.get_size() - 2);
+                    p = skip_value(p, stack);
+                    if (SAJSON_UNLIKELY(!p)) {
+                        return false;
+                    }
+                    goto structure_close_or_comma;
+                }
+                if (sel == projection::select_all) {
+                    child_proj = nullptr;
+                }
+            }
             goto next_element;
         }
 
@@ -1828,6 +1900,22 @@ private:
             }
 
             tag value_tag_result;
+            if (proj && current_structure_tag == tag::array) {
+                size_t index = stack.get_size() - current_base - 1;
+                auto sel = proj->select_index(index, child_proj);
+                if (sel == projection::select_none) {
+                    // keep a null in its place to preserve the indices
+                    p = skip_value(p, stack);
+                    if (SAJSON_UNLIKELY(!p)) {
+                        return false;
+                    }
+                    value_tag_result = tag::null;
+                    goto push_value;
+                }
+                if (sel == projection::select_all) {
+                    child_proj = nullptr;
+                }
+            }
             switch (*p) {
             case 0:
                 return unexpected_end(p);
@@ -1886,6 +1974,7 @@ private:
             }
 
             case '[': {
+                enter_projection(proj, child_proj, full_depth, proj_stack);
                 size_t previous_base = current_base;
                 current_base = stack.get_size();
                 bool s = stack.push(
@@ -1897,6 +1986,7 @@ private:
                 goto array_close_or_element;
             }
             case '{': {
+                enter_projection(proj, child_proj, full_depth, proj_stack);
                 size_t previous_base = current_base;
                 current_base = stack.get_size();
                 bool s = stack.push(
@@ -1921,6 +2011,11 @@ private:
                 current_base = parent;
                 value_tag_result = current_structure_tag;
                 current_structure_tag = get_element_tag(pop_element);
+                if (full_depth) {
+                    --full_depth;
+                } else {
+                    proj = proj_stack.data[--proj_stack.size];
+                }
                 break;
             }
 
@@ -1930,6 +2025,7 @@ private:
                 return make_error(p, ERROR_EXPECTED_VALUE);
             }
 
+        push_value:
             bool s = stack.push(
                 make_element(value_tag_result, allocator.get_write_offset()));
             if (SAJSON_UNLIKELY(!s)) {
@@ -1942,6 +2038,190 @@ private:
         SAJSON_UNREACHABLE();
     }
 
+    struct projection_stack {
+        explicit projection_stack(const projection* root)
+            : data(root ? new (std::nothrow) const projection*[root->depth()]
+                        : nullptr)
+            , size(0) {}
+        ~projection_stack() { delete[] data; }
+
+        projection_stack(const projection_stack&) = delete;
+        projection_stack& operator=(const projection_stack&) = delete;
+
+        const projection** data;
+        size_t size;
+    };
+
+    static void enter_projection(
+        const projection*& proj,
+        const projection* child_proj,
+        size_t& full_depth,
+        projection_stack& proj_stack) {
+        if (proj) {
+            proj_stack.data[proj_stack.size++] = proj;
+            proj = child_proj;
+        } else {
+            ++full_depth;
+        }
+    }
+
+    // validate a value without storing anything in the AST
+    // strings are still unescaped in place
+    template <typename Stack>
+    char* skip_value(char* p, Stack& stack) {
+        using namespace internal;
+
+        size_t base = stack.get_size();
+        size_t scratch[2];
+
+    value:
+        p = skip_whitespace(p);
+        if (SAJSON_UNLIKELY(!p)) {
+            return unexpected_end();
+        }
+        switch (*p) {
+        case 'n':
+            p = parse_null(p);
+            break;
+        case 'f':
+            p = parse_false(p);
+            break;
+        case 't':
+            p = parse_true(p);
+            break;
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+        case '-':
+            p = skip_number(p);
+            break;
+        case '"':
+            p = parse_string(p, scratch);
+            break;
+        case '[':
+        case '{': {
+            bool is_array = *p == '[';
+            if (SAJSON_UNLIKELY(!stack.push(is_array))) {
+                return oom(p, "stack.push skipped structure");
+            }
+            p = skip_whitespace(p + 1);
+            if (SAJSON_UNLIKELY(!p)) {
+                return unexpected_end();
+            }
+            if (*p == (is_array ? ']' : '}')) {
+                stack.reset(stack.get_size() - 1);
+                ++p;
+                break;
+            }
+            if (is_array) {
+                goto value;
+            }
+            goto key;
+        }
+        default:
+            return make_error(p, ERROR_EXPECTED_VALUE);
+        }
+        if (SAJSON_UNLIKELY(!p)) {
+            return 0;
+        }
+
+        // close structures or move to the next value
+        while (stack.get_size() != base) {
+            p = skip_whitespace(p);
+            if (SAJSON_UNLIKELY(!p)) {
+                return unexpected_end();
+            }
+            bool is_array = stack.get_top()[-1];
+            if (*p == (is_array ? ']' : '}')) {
+                stack.reset(stack.get_size() - 1);
+                ++p;
+                continue;
+            }
+            if (SAJSON_UNLIKELY(*p != ',')) {
+                return make_error(p, ERROR_EXPECTED_COMMA);
+            }
+            ++p;
+            if (is_array) {
+                goto value;
+            }
+            goto key;
+        }
+        return p;
+
+    key:
+        p = skip_whitespace(p);
+        if (SAJSON_UNLIKELY(!p)) {
+            return unexpected_end();
+        }
+        if (SAJSON_UNLIKELY(*p != '"')) {
+            return make_error(p, ERROR_MISSING_OBJECT_KEY);
+        }
+        p = parse_string(p, scratch);
+        if (SAJSON_UNLIKELY(!p)) {
+            return 0;
+        }
+        p = skip_whitespace(p);
+        if (SAJSON_UNLIKELY(!p || *p != ':')) {
+            return make_error(p, ERROR_EXPECTED_COLON);
+        }
+        ++p;
+        goto value;
+    }
+
+    // validate a number without converting it
+    char* skip_number(char* p) {
+        auto digit = [&](const char* c) {
+            return !at_eof(c) && *c >= '0' && *c <= '9';
+        };
+
+        if (*p == '-') {
+            ++p;
+        }
+        if (SAJSON_UNLIKELY(at_eof(p))) {
+            return unexpected_end(p);
+        }
+        if (*p == '0') {
+            ++p;
+        } else if (digit(p)) {
+            while (digit(p)) {
+                ++p;
+            }
+        } else {
+            return make_error(p, ERROR_INVALID_NUMBER);
+        }
+
+        if (!at_eof(p) && *p == '.') {
+            ++p;
+            if (SAJSON_UNLIKELY(!digit(p))) {
+                return make_error(p, ERROR_INVALID_NUMBER);
+            }
+            while (digit(p)) {
+                ++p;
+            }
+        }
+
+        if (!at_eof(p) && (*p == 'e' || *p == 'E')) {
+            ++p;
+            if (!at_eof(p) && (*p == '+' || *p == '-')) {
+                ++p;
+            }
+            if (SAJSON_UNLIKELY(!digit(p))) {
+                return make_error(p, ERROR_MISSING_EXPONENT);
+            }
+            while (digit(p)) {
+                ++p;
+            }
+        }
+        return p;
+    }
+
     bool has_remaining_characters(char* p, ptrdiff_t remaining) {
         return input_end - p >= remaining;
     }
@@ -2573,6 +2853,7 @@ private:
     mutable_string_view input;
     char* const input_end;
     Allocator allocator;
+    const projection* root_projection;
 
     internal::tag root_tag;
     size_t error_line;
@@ -2607,4 +2888,26 @@ document parse(const AllocationStrategy& strategy, const StringType& string) {
                input, std::move(allocator))
         .get_document();
 }
+
+/**
+ * Parses a string of JSON bytes into a \ref document, storing only the
+ * values selected by the projection (if not null).
+ */
+template <typename AllocationStrategy, typename StringType>
+document parse(
+    const AllocationStrategy& strategy,
+    const StringType& string,
+    const projection* proj) {
+    mutable_string_view input(string);
+
+    bool success;
+    auto allocator = strategy.make_allocator(input.length(), &success);
+    if (!success) {
+        return document(input, 1, 1, ERROR_OUT_OF_MEMORY, 0);
+    }
+
+    return parser<typename AllocationStrategy::allocator>(
+               input, std::move(allocator), proj)
+        .get_document();
+}
 } // namespace sajson
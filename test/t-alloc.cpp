@@ -0,0 +1,535 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include <doctest/doctest.h>
+
+#include <huse/json/Deserializer.hpp>
+#include <huse/json/Serializer.hpp>
+
+#include <huse/helpers/StdVector.hpp>
+#include <huse/helpers/StdMap.hpp>
+#include <huse/helpers/StdUnorderedMap.hpp>
+#include <huse/helpers/FlatMap.hpp>
+#include <huse/helpers/StdArray.hpp>
+#include <huse/helpers/StdOptional.hpp>
+#include <huse/helpers/StdVariant.hpp>
+#include <huse/helpers/StdPmr.hpp>
+
+#include <huse/Exception.hpp>
+#include <huse/StringPool.hpp>
+
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <type_traits>
+
+// count allocations in this executable
+namespace
+{
+int numAllocations = 0;
+}
+
+void* operator new(size_t size)
+{
+    ++numAllocations;
+    if (auto p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    ++numAllocations;
+    return std::malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t& nt) noexcept { return operator new(size, nt); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+TEST_SUITE_BEGIN("alloc");
+
+namespace
+{
+template <typename T>
+std::string toJson(const T& t)
+{
+    std::ostringstream sout;
+    {
+        auto s = huse::json::Make_Serializer(sout);
+        auto root = s.root();
+        root.val(t);
+    }
+    return sout.str();
+}
+
+// allocations made while reading (the deserializer is created before counting)
+template <typename T, typename F>
+int countRead(const std::string& json, T& t, F f)
+{
+    auto d = huse::json::Make_Deserializer(json);
+    auto root = d.root();
+    auto before = numAllocations;
+    root.cval(t, f);
+    return numAllocations - before;
+}
+
+template <typename T>
+int countRead(const std::string& json, T& t)
+{
+    return countRead(json, t, [](huse::DeserializerNode& n, T& v) { n.val(v); });
+}
+}
+
+TEST_CASE("unordered_map")
+{
+    // reading allocates as much as building the same map by hand
+    auto countBuild = [](const auto& map) {
+        auto before = numAllocations;
+        std::decay_t<decltype(map)> built;
+        built.reserve(map.size());
+        for (auto& e : map) built.emplace(e);
+        return numAllocations - before;
+    };
+
+    std::unordered_map<std::string, int> map;
+    for (int i = 0; i < 100; ++i) map["k" + std::to_string(i)] = i;
+    auto json = toJson(map);
+
+    std::unordered_map<std::string, int> read;
+    CHECK(countRead(json, read) == countBuild(map));
+    CHECK(read == map);
+
+    std::unordered_map<int, int> imap;
+    for (int i = 0; i < 50; ++i) imap[i * 3] = i;
+    json = toJson(imap);
+    std::unordered_map<int, int> iread;
+    CHECK(countRead(json, iread) == countBuild(imap));
+    CHECK(iread == imap);
+
+    // reading the same keys again doesn't allocate
+    CHECK(countRead(json, iread) == 0);
+    CHECK(iread == imap);
+}
+
+TEST_CASE("heterogeneous lookup")
+{
+    std::map<std::string, std::vector<int>, std::less<>> map = {
+        {"a long key which doesn't fit in sso", {1, 2, 3}},
+        {"another long key which doesn't fit", {4, 5}},
+    };
+    auto json = toJson(map);
+
+    // existing entries are updated in place: no keys and no vectors are allocated
+    auto read = map;
+    for (auto& e : read) e.second.assign(e.second.size(), 0);
+    CHECK(countRead(json, read) == 0);
+    CHECK(read == map);
+}
+
+TEST_CASE("flat map")
+{
+    std::vector<std::pair<int, int>> flat;
+    for (int i = 0; i < 100; ++i) flat.emplace_back(i, i * i);
+    std::ostringstream fout;
+    {
+        auto s = huse::json::Make_Serializer(fout);
+        auto root = s.root();
+        root.cval(flat, huse::FlatMapLike{true});
+    }
+    auto json = fout.str();
+    CHECK(json.substr(0, 16) == "[[0,0],[1,1],[2,");
+
+    std::vector<std::pair<int, int>> read;
+    CHECK(countRead(json, read, huse::FlatMapLike{}) == 1); // reserve
+    CHECK(read == flat);
+
+    // sorted input with duplicates reuses the capacity
+    CHECK(countRead("[[1,1],[1,3],[2,2],[3,0]]", read, huse::FlatMapLike{}) == 0);
+    CHECK(read == std::vector<std::pair<int, int>>{{1, 3}, {2, 2}, {3, 0}});
+
+    // unsorted input is sorted once
+    // (with a stable sort, which may allocate a temporary buffer)
+    std::string unsorted = R"([[3,0],[1,1],[2,2],[1,3]])";
+    countRead(unsorted, read, huse::FlatMapLike{});
+    REQUIRE(read.size() == 3);
+    CHECK(read[0] == std::pair(1, 3)); // the last duplicate
+    CHECK(read[1] == std::pair(2, 2));
+    CHECK(read[2] == std::pair(3, 0));
+
+    std::vector<std::pair<std::string, int>> sflat = {{"a", 1}, {"b", 2}};
+    std::ostringstream sout;
+    {
+        auto s = huse::json::Make_Serializer(sout);
+        auto root = s.root();
+        root.cval(sflat, huse::FlatMapLike{});
+    }
+    CHECK(sout.str() == R"({"a":1,"b":2})");
+    std::vector<std::pair<std::string, int>> sread;
+    CHECK(countRead(R"({"a":1,"b":2})", sread, huse::FlatMapLike{}) == 1); // reserve
+    CHECK(sread == sflat);
+    countRead(R"({"b":2,"a":1})", sread, huse::FlatMapLike{});
+    CHECK(sread == sflat);
+}
+
+TEST_CASE("array")
+{
+    std::array<int, 5> arr = {1, 2, 3, 4, 5};
+    auto json = toJson(arr);
+    CHECK(json == "[1,2,3,4,5]");
+
+    std::array<int, 5> read = {};
+    CHECK(countRead(json, read) == 0);
+    CHECK(read == arr);
+
+    int carr[5] = {};
+    CHECK(countRead(json, carr) == 0);
+    CHECK(carr[4] == 5);
+
+    std::array<int, 4> wrong;
+    CHECK_THROWS_AS(countRead(json, wrong), huse::DeserializerException);
+}
+
+TEST_CASE("optional")
+{
+    std::vector<std::optional<std::vector<int>>> opts = {std::vector<int>{1, 2}, std::nullopt};
+    auto json = toJson(opts);
+    CHECK(json == "[[1,2],null]");
+
+    std::vector<std::optional<std::vector<int>>> read(2);
+    read[0].emplace().reserve(2);
+    read[1].emplace();
+    CHECK(countRead(json, read) == 0); // the engaged value is reused
+    CHECK(read == opts);
+}
+
+TEST_CASE("variant")
+{
+    using Var = std::variant<std::monostate, bool, int, double, std::string, std::vector<int>>;
+    std::vector<Var> vars = {std::monostate{}, true, 5, 2.5, std::string("str"), std::vector<int>{1, 2}};
+    auto json = toJson(vars);
+    CHECK(json == R"([null,true,5,2.5,"str",[1,2]])");
+
+    // as much as a copy: the vector and the vector alternative (the string is short)
+    auto before = numAllocations;
+    auto copy = vars;
+    auto copyAllocations = numAllocations - before;
+    std::vector<Var> read;
+    CHECK(countRead(json, read) == copyAllocations);
+    CHECK(read == vars);
+
+    // the held alternative is reused
+    std::vector<Var> one(1);
+    one[0].emplace<std::vector<int>>().reserve(3);
+    CHECK(countRead("[[1,2,3]]", one) == 0);
+    CHECK(std::get<std::vector<int>>(one[0]) == std::vector<int>{1, 2, 3});
+
+    std::vector<std::variant<int, std::string>> nope(1);
+    CHECK_THROWS_AS(countRead("[1.5]", nope), huse::DeserializerException);
+}
+
+struct Part
+{
+    std::string label;
+    std::vector<int> values;
+
+    template <typename Node, typename Self>
+    static void sh(Node& n, Self& s)
+    {
+        auto obj = n.obj();
+        obj.val("label", s.label);
+        obj.val("values", s.values);
+    }
+    void huseSerialize(huse::SerializerNode& n) const { sh(n, *this); }
+    void huseDeserialize(huse::DeserializerNode& n) { sh(n, *this); }
+};
+
+struct Message
+{
+    std::string name;
+    std::vector<Part> parts;
+    std::optional<std::string> note;
+
+    template <typename Node, typename Self>
+    static void sh(Node& n, Self& s)
+    {
+        auto obj = n.obj();
+        obj.val("name", s.name);
+        obj.val("parts", s.parts);
+        obj.val("note", s.note);
+    }
+    void huseSerialize(huse::SerializerNode& n) const { sh(n, *this); }
+    void huseDeserialize(huse::DeserializerNode& n) { sh(n, *this); }
+};
+
+TEST_CASE("reuse")
+{
+    auto makeMessage = [](int frame, int numParts) {
+        Message msg;
+        msg.name = "a message name which is too long for sso " + std::to_string(frame);
+        for (int i = 0; i < numParts; ++i)
+        {
+            auto& p = msg.parts.emplace_back();
+            p.label = "a part label which is too long for sso " + std::to_string((frame + i) % 10);
+            for (int j = 0; j <= i + frame % 3; ++j) p.values.push_back(j * frame);
+        }
+        msg.note = "a note which is also too long for sso " + std::to_string(frame);
+        return msg;
+    };
+
+    Message msg;
+    CHECK(countRead(toJson(makeMessage(2, 4)), msg) > 0); // warm-up with the biggest message
+
+    // fewer parts than before read into the existing ones
+    int numParts = 4;
+    for (int frame = 3; frame < 9; ++frame)
+    {
+        auto expected = makeMessage(frame, numParts);
+        auto json = toJson(expected);
+        CHECK(countRead(json, msg) == 0);
+        CHECK(msg.name == expected.name);
+        REQUIRE(msg.parts.size() == size_t(numParts));
+        CHECK(msg.parts.back().label == expected.parts.back().label);
+        CHECK(msg.parts.back().values == expected.parts.back().values);
+        CHECK(msg.note == expected.note);
+        if (frame % 2) --numParts;
+    }
+
+    // the parts past a shorter input were destroyed, so more parts allocate again
+    REQUIRE(numParts == 1);
+    CHECK(countRead(toJson(makeMessage(10, 3)), msg) > 0);
+    CHECK(msg.parts.size() == 3);
+    CHECK(countRead(toJson(makeMessage(12, 3)), msg) == 0);
+}
+
+struct Request
+{
+    std::pmr::string name;
+    std::pmr::vector<std::pmr::string> tags;
+    std::pmr::map<std::pmr::string, std::pmr::vector<int>> values;
+
+    Request() = default;
+    explicit Request(std::pmr::memory_resource* r) : name(r), tags(r), values(r) {}
+
+    template <typename Node, typename Self>
+    static void sh(Node& n, Self& s)
+    {
+        auto obj = n.obj();
+        obj.val("name", s.name);
+        obj.val("tags", s.tags);
+        obj.val("values", s.values);
+    }
+    void huseSerialize(huse::SerializerNode& n) const { sh(n, *this); }
+    void huseDeserialize(huse::DeserializerNode& n) { sh(n, *this); }
+};
+
+TEST_CASE("pmr")
+{
+    Request expected;
+    expected.name = "a request name which is too long for sso";
+    expected.tags = {"a tag which is also too long for sso", "short"};
+    expected.values["a key which is too long for sso as well"] = {1, 2, 3};
+    expected.values["k"] = {};
+    auto json = toJson(expected);
+
+    // the arena can't fall back to the global allocator
+    char buf[4096];
+    std::pmr::monotonic_buffer_resource arena(buf, sizeof(buf), std::pmr::null_memory_resource());
+
+    huse::json::DeserializerOptions opts;
+    opts.memoryResource = &arena;
+
+    // the copy of the input and the ast are in the arena
+    auto before = numAllocations;
+    {
+        auto d = huse::json::Make_Deserializer(json);
+    }
+    auto withoutResource = numAllocations - before;
+    before = numAllocations;
+    auto d = huse::json::Make_Deserializer(json, opts);
+    CHECK(withoutResource - (numAllocations - before) == 2);
+    CHECK(d.memoryResource() == &arena);
+
+    // elements get the resource of their containers
+    Request req(&arena);
+    before = numAllocations;
+    d.root().val(req);
+    CHECK(numAllocations == before);
+
+    CHECK(req.name == expected.name);
+    CHECK(req.tags == expected.tags);
+    CHECK(req.values == expected.values);
+    CHECK(req.tags[0].get_allocator().resource() == &arena);
+    CHECK(req.values.begin()->first.get_allocator().resource() == &arena);
+    CHECK(req.values.begin()->second.get_allocator().resource() == &arena);
+
+    // existing values keep their resource
+    std::pmr::unsynchronized_pool_resource pool;
+    std::pmr::string str(&pool);
+    Request dreq;
+    auto d2 = huse::json::Make_Deserializer(R"(["a string which is too long for sso"])", opts);
+    {
+        auto root = d2.root();
+        auto ar = root.ar();
+        ar.val(str);
+    }
+    CHECK(str == "a string which is too long for sso");
+    CHECK(str.get_allocator().resource() == &pool);
+    d.root().val(dreq);
+    CHECK(dreq.values == expected.values);
+    CHECK(dreq.name.get_allocator().resource() == std::pmr::get_default_resource());
+    CHECK(dreq.values.begin()->first.get_allocator().resource() == std::pmr::get_default_resource());
+
+    // pmr values in other containers get the resource of the deserializer
+    std::vector<std::pmr::string> strs;
+    std::map<std::string, std::optional<std::pmr::string>> notes;
+    auto d3 = huse::json::Make_Deserializer(R"([["a string which is too long for sso"],{"a":"x"}])", opts);
+    {
+        auto root = d3.root();
+        auto ar = root.ar();
+        ar.val(strs);
+        ar.val(notes);
+    }
+    REQUIRE(strs.size() == 1);
+    CHECK(strs[0].get_allocator().resource() == &arena);
+    REQUIRE(notes["a"]);
+    CHECK(notes["a"]->get_allocator().resource() == &arena);
+
+    // without a resource everything works as usual
+    auto plain = huse::json::Make_Deserializer(json);
+    CHECK(plain.memoryResource() == std::pmr::get_default_resource());
+    Request preq;
+    plain.root().val(preq);
+    CHECK(preq.values == expected.values);
+    CHECK(preq.name.get_allocator().resource() == std::pmr::get_default_resource());
+}
+
+TEST_CASE("pmr two arenas")
+{
+    // one value read by deserializers with different arenas in sequence
+    std::pmr::monotonic_buffer_resource arena1, arena2;
+    huse::json::DeserializerOptions opts1, opts2;
+    opts1.memoryResource = &arena1;
+    opts2.memoryResource = &arena2;
+
+    const std::string short1 = R"(["a string which is too long for sso"])";
+    const std::string long2 = R"(["another string which is too long for sso","and another one which is long too"])";
+
+    std::vector<std::pmr::string> strs;
+    {
+        auto d = huse::json::Make_Deserializer(short1, opts1);
+        d.root().val(strs);
+    }
+    REQUIRE(strs.size() == 1);
+    CHECK(strs[0].get_allocator().resource() == &arena1);
+
+    // the existing element keeps its arena and only the new one gets the second arena
+    {
+        auto d = huse::json::Make_Deserializer(long2, opts2);
+        d.root().val(strs);
+    }
+    REQUIRE(strs.size() == 2);
+    CHECK(strs[0] == "another string which is too long for sso");
+    CHECK(strs[1] == "and another one which is long too");
+    CHECK(strs[0].get_allocator().resource() == &arena1);
+    CHECK(strs[1].get_allocator().resource() == &arena2);
+
+    // a value constructed with an arena stays in it
+    Request req(&arena1);
+    req.values["a key which is too long for sso as well"] = {1};
+    for (auto* opts : {&opts1, &opts2})
+    {
+        auto d = huse::json::Make_Deserializer(R"({"name":"a request name which is too long for sso","tags":["a tag which is also too long for sso"],"values":{"k":[2]}})", *opts);
+        d.root().val(req);
+        CHECK(req.name == "a request name which is too long for sso");
+        CHECK(req.name.get_allocator().resource() == &arena1);
+        REQUIRE(req.tags.size() == 1);
+        CHECK(req.tags[0].get_allocator().resource() == &arena1);
+        CHECK(req.values.size() == 2);
+        CHECK(req.values["k"] == std::pmr::vector<int>{2});
+        CHECK(req.values["k"].get_allocator().resource() == &arena1);
+    }
+}
+
+TEST_CASE("interned")
+{
+    huse::StringPool pool;
+    auto json = R"(["ACTIVE","a status which is too long for sso","ACTIVE"])";
+
+    std::vector<huse::InternedString> read;
+    auto f = [&](huse::DeserializerNode& n, std::vector<huse::InternedString>& v) {
+        auto ar = n.ar();
+        v.resize(ar.length());
+        for (auto& s : v) ar.cval(s, huse::Interned{pool});
+    };
+    CHECK(countRead(json, read, f) > 0);
+    CHECK(read[0] == read[2]);
+
+    // values which are already in the pool don't allocate
+    CHECK(countRead(json, read, f) == 0);
+    CHECK(read[1].str() == "a status which is too long for sso");
+}
+
+TEST_CASE("key shape")
+{
+    huse::KeyShape shape;
+    struct Point { int x, y; } p = {};
+    auto f = [&](huse::DeserializerNode& n, Point& v) {
+        auto o = n.obj();
+        o.shape(shape);
+        o.val("x", v.x);
+        o.val("y", v.y);
+    };
+
+    CHECK(countRead(R"({"x": 1, "y": 2})", p, f) > 0); // the shape grows
+    // relearning a different layout doesn't allocate
+    CHECK(countRead(R"({"y": 4, "x": 3})", p, f) == 0);
+    CHECK(p.x == 3);
+    CHECK(shape[0] == 1);
+    CHECK(countRead(R"({"y": 6, "x": 5})", p, f) == 0);
+    CHECK(p.y == 6);
+}
+
+TEST_CASE("bookmark")
+{
+    int i = 0;
+    auto f = [&](huse::DeserializerNode& n, int& v) {
+        auto ar = n.ar();
+        for (int pass = 0; pass < 3; ++pass)
+        {
+            auto bm = ar.bookmark();
+            ar.val(v);
+            ar.restore(bm);
+        }
+    };
+    CHECK(countRead("[[[5]]]", i, [&](huse::DeserializerNode& n, int& v) {
+        auto a = n.ar();
+        auto b = a.ar();
+        b.cval(v, f);
+    }) == 0);
+    CHECK(i == 5);
+}
+
+TEST_CASE("lazy error text")
+{
+    huse::json::DeserializerOptions opts;
+    opts.throwOnError = false;
+
+    std::vector<int> ints;
+    huse::DeserializerResult r;
+    {
+        auto d = huse::json::Make_Deserializer(R"([1, 2, "three"])", opts);
+        r = d.tryVal(ints);
+    }
+
+    // checking the code formats nothing
+    auto before = numAllocations;
+    CHECK(r.code() == huse::ErrorCode::TypeMismatch);
+    CHECK(numAllocations == before);
+
+    // the text outlives the deserializer and is formatted once
+    CHECK(r.text() == "root.[2] : not an integer");
+    before = numAllocations;
+    CHECK(r.text() == "root.[2] : not an integer");
+    CHECK(numAllocations == before);
+}
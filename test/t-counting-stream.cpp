@@ -0,0 +1,93 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include <doctest/doctest.h>
+
+#include <huse/CountingStream.hpp>
+#include <huse/Exception.hpp>
+#include <huse/json/Serializer.hpp>
+#include <huse/helpers/StdVector.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+TEST_SUITE_BEGIN("counting stream");
+
+struct Record
+{
+    std::string name;
+    std::vector<double> values;
+    std::string note;
+
+    void huseSerialize(huse::SerializerNode& n) const
+    {
+        auto o = n.obj();
+        o.val("name", name);
+        o.val("values", values);
+        o.sstream("note") << note << ' ' << values.size();
+    }
+};
+
+std::string toJson(const Record& r, bool pretty)
+{
+    std::ostringstream sout;
+    {
+        auto s = huse::json::Make_Serializer(sout, pretty);
+        auto root = s.root();
+        root.val(r);
+    }
+    return sout.str();
+}
+
+TEST_CASE("exact size")
+{
+    Record r = {"a \"quoted\"\tname", {1.5, -2, 3e100, 0.1}, std::string(1000, '\n')};
+
+    for (bool pretty : {false, true})
+    {
+        auto json = toJson(r, pretty);
+        CHECK(huse::serializedSize(r, pretty) == json.size());
+        CHECK(huse::serializeExact(r, pretty) == json);
+    }
+}
+
+TEST_CASE("fixed buffer")
+{
+    Record r = {"name", {1, 2, 3}, "note"};
+    auto json = toJson(r, false);
+
+    std::vector<char> buf(json.size() + 10);
+    CHECK(huse::serializeTo(buf.data(), buf.size(), r) == json.size());
+    CHECK(std::string_view(buf.data(), json.size()) == json);
+
+    CHECK(huse::serializeTo(buf.data(), json.size(), r) == json.size());
+
+    try
+    {
+        huse::serializeTo(buf.data(), json.size() - 1, r);
+        CHECK(false);
+    }
+    catch (huse::SerializerException& e)
+    {
+        CHECK(e.code() == huse::ErrorCode::OutOfRange);
+    }
+
+    // overflow inside the string stream
+    r.note = std::string(100, 'x');
+    json = toJson(r, false);
+    buf.resize(json.size());
+    CHECK_THROWS_AS(huse::serializeTo(buf.data(), json.size() - 50, r), huse::SerializerException);
+
+    huse::FixedBufferStreambuf fixed(buf.data(), 10);
+    std::ostream out(&fixed);
+    {
+        auto s = huse::json::Make_Serializer(out);
+        auto root = s.root();
+        root.val(r);
+    }
+    CHECK(fixed.overflowed());
+    CHECK(fixed.size() == 10);
+    CHECK(fixed.requiredSize() == json.size());
+    CHECK(std::string_view(buf.data(), 10) == json.substr(0, 10));
+}
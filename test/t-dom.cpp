@@ -0,0 +1,295 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include <doctest/doctest.h>
+
+#include <huse/dom/Deserializer.hpp>
+#include <huse/dom/Serializer.hpp>
+
+#include <huse/helpers/StdVector.hpp>
+
+#include <huse/Exception.hpp>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+TEST_SUITE_BEGIN("dom");
+
+using Kind = huse::dom::Value::Kind;
+
+TEST_CASE("dom serialize")
+{
+    huse::dom::Document doc;
+    {
+        auto s = huse::dom::Make_Serializer(doc);
+        auto root = s.root();
+        auto obj = root.obj();
+        obj.val("i", -5);
+        obj.val("big", std::numeric_limits<uint64_t>::max());
+        obj.val("f", 2.5);
+        obj.val("b", true);
+        obj.val("n", nullptr);
+        obj.val("short", "abc");
+        obj.val("long", "a string which doesn't fit in the small buffer");
+        {
+            auto ar = obj.ar("ar");
+            ar.val(1);
+            ar.obj().val("x", 2);
+            ar.ar();
+        }
+        obj.sstream("ss") << 1 << ' ' << 2;
+        obj.val("skipped", std::nullopt);
+    }
+
+    auto& r = doc.root();
+    REQUIRE(r.isObject());
+    REQUIRE(r.size() == 9);
+
+    CHECK(r.member(0).key.asString() == "i");
+    CHECK(r.member(0).value.asInt() == -5);
+
+    auto big = r.find("big");
+    REQUIRE(big);
+    CHECK(big->kind() == Kind::UInteger);
+    CHECK(big->asUInt() == std::numeric_limits<uint64_t>::max());
+
+    CHECK(r.find("f")->asDouble() == 2.5);
+    CHECK(r.find("b")->asBool());
+    CHECK(r.find("n")->isNull());
+    CHECK(r.find("short")->asString() == "abc");
+    CHECK(r.find("long")->asString() == "a string which doesn't fit in the small buffer");
+    CHECK(r.find("ss")->asString() == "1 2");
+    CHECK_FALSE(r.find("skipped"));
+
+    auto ar = r.find("ar");
+    REQUIRE(ar);
+    REQUIRE(ar->size() == 3);
+    CHECK(ar->element(0).asInt() == 1);
+    CHECK(ar->element(1).find("x")->asInt() == 2);
+    CHECK(ar->element(2).isArray());
+    CHECK(ar->element(2).size() == 0);
+
+    // moving the document doesn't invalidate the tree
+    auto moved = std::move(doc);
+    CHECK(moved.root().find("long")->asString() == "a string which doesn't fit in the small buffer");
+}
+
+struct Item
+{
+    std::string name;
+    int64_t id;
+    double weight;
+    std::vector<uint32_t> tags;
+    bool active;
+
+    template <typename N, typename Self>
+    static void serializeT(N& n, Self& self)
+    {
+        auto o = n.obj();
+        o.val("name", self.name);
+        o.val("id", self.id);
+        o.val("weight", self.weight);
+        o.val("tags", self.tags);
+        o.val("active", self.active);
+    }
+
+    void huseSerialize(huse::SerializerNode& n) const
+    {
+        serializeT(n, *this);
+    }
+
+    void huseDeserialize(huse::DeserializerNode& n)
+    {
+        serializeT(n, *this);
+    }
+};
+
+TEST_CASE("dom i/o")
+{
+    std::vector<Item> items = {
+        {"first", std::numeric_limits<int64_t>::min(), 0.1, {1, 2, 3}, true},
+        {"a much longer name for the second item", 1ll << 60, 1e300, {}, false},
+    };
+
+    huse::dom::Document doc;
+    huse::dom::Make_Serializer(doc).root().val(items);
+
+    std::vector<Item> cc;
+    {
+        auto d = huse::dom::Make_Deserializer(doc);
+        d.root().val(cc);
+    }
+
+    REQUIRE(cc.size() == 2);
+    for (size_t i = 0; i < 2; ++i)
+    {
+        CHECK(cc[i].name == items[i].name);
+        CHECK(cc[i].id == items[i].id);
+        CHECK(cc[i].weight == items[i].weight); // exact, no text in between
+        CHECK(cc[i].tags == items[i].tags);
+        CHECK(cc[i].active == items[i].active);
+    }
+
+    // serializing again replaces the old contents
+    huse::dom::Make_Serializer(doc).root().val(5);
+    CHECK(doc.root().asInt() == 5);
+}
+
+TEST_CASE("dom move")
+{
+    const std::string str = "a string which is too long to be stored inline";
+    const std::string other = "another string which is too long to be inline";
+    huse::dom::Document a;
+    a.setRoot(huse::dom::Value::string(str, a.arena()));
+
+    {
+        auto b = std::move(a);
+        CHECK(b.root().asString() == str);
+        CHECK(a.root().isNull());
+
+        // the moved-from document allocates in its own memory, which outlives b
+        a.setRoot(huse::dom::Value::string(other, a.arena()));
+        CHECK(b.root().asString() == str);
+    }
+    CHECK(a.root().asString() == other);
+
+    huse::dom::Document c;
+    {
+        huse::dom::Document d;
+        d.setRoot(huse::dom::Value::string(str, d.arena()));
+        c = std::move(d);
+        d.setRoot(huse::dom::Value::string(other, d.arena()));
+        CHECK(d.root().asString() == other);
+    }
+    CHECK(c.root().asString() == str);
+}
+
+TEST_CASE("dom deserialize")
+{
+    huse::dom::Document doc;
+    {
+        auto s = huse::dom::Make_Serializer(doc);
+        auto root = s.root();
+        auto obj = root.obj();
+        obj.val("a", 1);
+        obj.val("b", -1);
+        obj.val("c", 3.5);
+        obj.val("d", 300);
+        obj.sstream("e") << "12 xyz";
+    }
+
+    auto d = huse::dom::Make_Deserializer(doc);
+    {
+        auto root = d.root();
+        auto obj = root.obj();
+
+        // out of order
+        double c;
+        obj.val("c", c);
+        CHECK(c == 3.5);
+        int a;
+        obj.val("a", a);
+        CHECK(a == 1);
+        float b;
+        obj.val("b", b);
+        CHECK(b == -1);
+
+        int i;
+        std::string str;
+        obj.sstream("e") >> i >> str;
+        CHECK(i == 12);
+        CHECK(str == "xyz");
+
+        CHECK(obj.optkey("d"));
+        CHECK_FALSE(obj.optkey("z"));
+    }
+
+    double c;
+    d.at("/c").val(c);
+    CHECK(c == 3.5);
+    CHECK_THROWS_AS(d.at("/z"), huse::DeserializerException);
+}
+
+TEST_CASE("dom exceptions")
+{
+    huse::dom::Document doc;
+    {
+        auto s = huse::dom::Make_Serializer(doc);
+        auto root = s.root();
+        auto obj = root.obj();
+        obj.val("neg", -1);
+        obj.val("big", 100000);
+        obj.val("frac", 1.5);
+        obj.val("str", "x");
+        auto ar = obj.ar("ar");
+        ar.val(1);
+    }
+
+    auto expect = [&](auto func, huse::ErrorCode code, std::string_view what) {
+        auto d = huse::dom::Make_Deserializer(doc);
+        try
+        {
+            auto root = d.root();
+            auto obj = root.obj();
+            func(obj);
+            CHECK(false);
+        }
+        catch (huse::DeserializerException& e)
+        {
+            CHECK(e.code() == code);
+            CHECK(std::string_view(e.what()) == what);
+        }
+    };
+
+    expect([](huse::DeserializerObject& o) { unsigned u; o.val("neg", u); },
+        huse::ErrorCode::NumberRange, R"(root."neg" : negative integer)");
+    expect([](huse::DeserializerObject& o) { short s; o.val("big", s); },
+        huse::ErrorCode::NumberRange, R"(root."big" : integer doesn't fit in target type)");
+    expect([](huse::DeserializerObject& o) { int i; o.val("frac", i); },
+        huse::ErrorCode::TypeMismatch, R"(root."frac" : not an integer)");
+    expect([](huse::DeserializerObject& o) { int i; o.val("str", i); },
+        huse::ErrorCode::TypeMismatch, R"(root."str" : not an integer)");
+    expect([](huse::DeserializerObject& o) { std::string_view sv; o.val("big", sv); },
+        huse::ErrorCode::TypeMismatch, R"(root."big" : not a string)");
+    expect([](huse::DeserializerObject& o) { o.obj("ar"); },
+        huse::ErrorCode::TypeMismatch, R"(root."ar" : not an object)");
+    expect([](huse::DeserializerObject& o) { o.ar("ar").index(3); },
+        huse::ErrorCode::OutOfRange, R"(root."ar".[3] : out of range)");
+    expect([](huse::DeserializerObject& o) { o.key("zzz"); },
+        huse::ErrorCode::OutOfRange, R"(root."zzz" : out of range)");
+}
+
+TEST_CASE("dom length limit")
+{
+    if constexpr (sizeof(size_t) > 4)
+    {
+        // only the length is checked, so nothing is accessed
+        const huse::dom::Value* elements = nullptr;
+        const size_t tooLong = size_t(huse::dom::Value::Max_Length) + 1;
+        CHECK_THROWS_AS(huse::dom::Value::array(elements, tooLong), huse::SerializerException);
+        CHECK_THROWS_AS(huse::dom::Value::object(nullptr, tooLong), huse::SerializerException);
+
+        huse::dom::Arena arena;
+        CHECK_THROWS_AS(huse::dom::Value::string(std::string_view("x", tooLong), arena), huse::SerializerException);
+    }
+    CHECK(huse::dom::Value::array(nullptr, 0).size() == 0);
+}
+
+TEST_CASE("dom raw")
+{
+    huse::dom::Document doc;
+    {
+        auto s = huse::dom::Make_Serializer(doc);
+        auto root = s.root();
+        auto obj = root.obj();
+        obj.raw("fragment", R"({"a": [1, "x"], "b": 2.5})");
+        obj.val("c", 3);
+    }
+
+    auto frag = doc.root().find("fragment");
+    REQUIRE(frag);
+    CHECK(frag->find("a")->element(1).asString() == "x");
+    CHECK(frag->find("b")->asDouble() == 2.5);
+    CHECK(doc.root().find("c")->asInt() == 3);
+}
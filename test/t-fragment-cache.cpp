@@ -0,0 +1,198 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include <doctest/doctest.h>
+
+#include <huse/FragmentCache.hpp>
+#include <huse/json/Serializer.hpp>
+
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+TEST_SUITE_BEGIN("fragment cache");
+
+struct Entry
+{
+    std::string name;
+    int price;
+    uint64_t version = huse::FragmentCache::newVersion();
+
+    mutable int numSerialized = 0;
+
+    uint64_t huseVersion() const { return version; }
+
+    void huseSerialize(huse::SerializerNode& n) const
+    {
+        ++numSerialized;
+        auto o = n.obj();
+        o.val("name", name);
+        o.val("price", price);
+    }
+};
+
+std::string serializeAll(huse::FragmentCache& cache, const std::vector<Entry>& entries)
+{
+    std::ostringstream sout;
+    {
+        auto s = huse::json::Make_Serializer(sout);
+        auto root = s.root();
+        auto ar = root.ar();
+        for (auto& e : entries)
+        {
+            cache.val(ar, e);
+        }
+    }
+    return sout.str();
+}
+
+TEST_CASE("fragment cache basic")
+{
+    huse::FragmentCache cache;
+    std::vector<Entry> entries = {{"pen", 3}, {"book", 20}};
+
+    CHECK(serializeAll(cache, entries) == R"([{"name":"pen","price":3},{"name":"book","price":20}])");
+    auto stats = cache.stats();
+    CHECK(stats.hits == 0);
+    CHECK(stats.misses == 2);
+    CHECK(stats.entries == 2);
+
+    CHECK(serializeAll(cache, entries) == R"([{"name":"pen","price":3},{"name":"book","price":20}])");
+    stats = cache.stats();
+    CHECK(stats.hits == 2);
+    CHECK(stats.misses == 2);
+    CHECK(entries[0].numSerialized == 1);
+    CHECK(entries[1].numSerialized == 1);
+
+    // bumping the version invalidates
+    entries[1].price = 25;
+    entries[1].version = huse::FragmentCache::newVersion();
+    CHECK(serializeAll(cache, entries) == R"([{"name":"pen","price":3},{"name":"book","price":25}])");
+    stats = cache.stats();
+    CHECK(stats.hits == 3);
+    CHECK(stats.misses == 3);
+    CHECK(stats.entries == 2); // replaced
+    CHECK(entries[1].numSerialized == 2);
+
+    cache.erase(&entries[0]);
+    CHECK(cache.stats().entries == 1);
+    CHECK_FALSE(cache.find(&entries[0], typeid(Entry), 0));
+
+    cache.clear();
+    stats = cache.stats();
+    CHECK(stats.entries == 0);
+    CHECK(stats.bytes == 0);
+}
+
+TEST_CASE("fragment cache lru")
+{
+    // single stripe, so eviction order is predictable
+    huse::FragmentCache cache(10, 1);
+
+    int a, b, c;
+    cache.insert(&a, typeid(int), 0, "1111");
+    cache.insert(&b, typeid(int), 0, "2222");
+    CHECK(cache.find(&a, typeid(int), 0)); // a is now most recently used
+    cache.insert(&c, typeid(int), 0, "3333");
+
+    auto stats = cache.stats();
+    CHECK(stats.evictions == 1);
+    CHECK(stats.entries == 2);
+    CHECK(stats.bytes == 8);
+
+    CHECK(*cache.find(&a, typeid(int), 0) == "1111");
+    CHECK_FALSE(cache.find(&b, typeid(int), 0));
+    CHECK(*cache.find(&c, typeid(int), 0) == "3333");
+
+    // too big to fit, but still returned
+    auto big = cache.insert(&b, typeid(int), 0, "an entry bigger than the cache");
+    CHECK(*big == "an entry bigger than the cache");
+    CHECK(cache.stats().entries == 0);
+}
+
+struct Name
+{
+    std::string str;
+    uint64_t version = huse::FragmentCache::newVersion();
+    uint64_t huseVersion() const { return version; }
+    void huseSerialize(huse::SerializerNode& n) const { n.val(str); }
+};
+
+struct Named
+{
+    Name name;
+    int id = 0;
+    uint64_t version = huse::FragmentCache::newVersion();
+    uint64_t huseVersion() const { return version; }
+    void huseSerialize(huse::SerializerNode& n) const
+    {
+        auto o = n.obj();
+        o.val("id", id);
+    }
+};
+
+TEST_CASE("fragment cache types")
+{
+    huse::FragmentCache cache;
+    Named n;
+    n.name.str = "x";
+    n.id = 5;
+    REQUIRE(static_cast<const void*>(&n) == static_cast<const void*>(&n.name));
+
+    std::ostringstream sout;
+    {
+        auto s = huse::json::Make_Serializer(sout);
+        auto root = s.root();
+        auto ar = root.ar();
+        cache.val(ar, n);
+        cache.val(ar, n.name);
+        cache.val(ar, n);
+    }
+    CHECK(sout.str() == R"([{"id":5},"x",{"id":5}])");
+    CHECK(cache.stats().entries == 2);
+
+    cache.erase(&n.name);
+    CHECK(cache.find(&n, typeid(Named), n.version));
+    CHECK_FALSE(cache.find(&n, typeid(Name), n.name.version));
+}
+
+struct Tracked
+{
+    int value;
+    uint64_t version = huse::FragmentCache::newVersion();
+
+    uint64_t huseVersion() const { return version; }
+    void huseSerialize(huse::SerializerNode& n) const { n.val(value); }
+};
+
+TEST_CASE("fragment cache address reuse")
+{
+    huse::FragmentCache cache;
+    alignas(Tracked) char buf[sizeof(Tracked)];
+
+    auto write = [&](const Tracked& t) {
+        std::ostringstream sout;
+        {
+            auto s = huse::json::Make_Serializer(sout);
+            auto root = s.root();
+            cache.val(root, t);
+        }
+        return sout.str();
+    };
+
+    auto a = new (buf) Tracked{1};
+    CHECK(write(*a) == "1");
+    CHECK(write(*a) == "1");
+    CHECK(cache.stats().hits == 1);
+    auto oldVersion = a->version;
+    a->~Tracked(); // its entry is not erased
+
+    // same address and type, but a new version
+    auto b = new (buf) Tracked{2};
+    CHECK(b->version != oldVersion);
+    CHECK(write(*b) == "2");
+    CHECK(cache.stats().hits == 1);
+    CHECK(cache.stats().entries == 1); // replaced
+    b->~Tracked();
+}
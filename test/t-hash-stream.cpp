@@ -0,0 +1,139 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include <doctest/doctest.h>
+
+#include <huse/HashStream.hpp>
+#include <huse/json/Serializer.hpp>
+#include <huse/helpers/StdVector.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+TEST_SUITE_BEGIN("hash stream");
+
+namespace
+{
+uint64_t hashOf(std::string_view str, uint64_t seed = 0)
+{
+    huse::HashStreambuf hash(seed);
+    hash.sputn(str.data(), std::streamsize(str.size()));
+    return hash.digest();
+}
+
+std::string pattern(size_t size)
+{
+    std::string ret;
+    for (size_t i = 0; i < size; ++i) ret += char((i * 7 + 3) % 251);
+    return ret;
+}
+}
+
+TEST_CASE("xxh64")
+{
+    // expected values are from the reference implementation
+    CHECK(hashOf("") == 0xEF46DB3751D8E999ull);
+    CHECK(hashOf("a") == 0xD24EC4F1A98C6E5Bull);
+    CHECK(hashOf("abc") == 0x44BC2CF5AD770999ull);
+    CHECK(hashOf("", 42) == 0x98B1582B0977E704ull);
+    CHECK(hashOf("abc", 42) == 0x13C1D910702770E6ull);
+
+    auto p = pattern(1000);
+    CHECK(hashOf(p) == 0x021F7A7424085EA4ull);
+    CHECK(hashOf(p, 42) == 0x0BD07AD8A8492AE5ull);
+    CHECK(hashOf(std::string_view(p).substr(0, 31)) == 0xA2AA5F33CC4A6119ull);
+    CHECK(hashOf(std::string_view(p).substr(0, 32)) == 0x23C3C17EF790FD97ull);
+    CHECK(hashOf(std::string_view(p).substr(0, 33)) == 0x50A7CFC7BA588784ull);
+    CHECK(hashOf(std::string_view(p).substr(0, 255)) == 0xDDE56EF0B6572B40ull);
+    CHECK(hashOf(std::string_view(p).substr(0, 256)) == 0x88229896024C154Aull);
+    CHECK(hashOf(std::string_view(p).substr(0, 257)) == 0xDB12467136CDA502ull);
+    CHECK(hashOf(std::string_view(p).substr(0, 300)) == 0xB5F10BDB867F9E90ull);
+}
+
+TEST_CASE("chunked writes")
+{
+    auto p = pattern(1000);
+
+    for (size_t chunk : {1, 3, 31, 32, 33, 100, 256, 257, 999})
+    {
+        huse::HashStreambuf hash;
+        for (size_t i = 0; i < p.size(); i += chunk)
+        {
+            auto len = std::min(chunk, p.size() - i);
+            if (len == 1) hash.sputc(p[i]);
+            else hash.sputn(p.data() + i, std::streamsize(len));
+
+            // digest doesn't disturb the state
+            if (i == 0) hash.digest();
+        }
+        CHECK(hash.size() == 1000);
+        CHECK(hash.digest() == 0x021F7A7424085EA4ull);
+    }
+
+    huse::HashStreambuf hash;
+    hash.sputn(p.data(), 500);
+    hash.reset(42);
+    CHECK(hash.size() == 0);
+    hash.sputn(p.data(), 1000);
+    CHECK(hash.digest() == 0x0BD07AD8A8492AE5ull);
+}
+
+struct Item
+{
+    std::string name;
+    std::vector<int> values;
+    double weight;
+
+    void huseSerialize(huse::SerializerNode& n) const
+    {
+        auto o = n.obj();
+        o.val("name", name);
+        o.val("values", values);
+        o.val("weight", weight);
+    }
+};
+
+TEST_CASE("content hash")
+{
+    Item item = {"huse", {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}, 1.5};
+
+    std::ostringstream sout;
+    {
+        auto s = huse::json::Make_Serializer(sout);
+        auto root = s.root();
+        root.val(item);
+    }
+
+    auto h = huse::contentHash(item);
+    CHECK(h == hashOf(sout.str()));
+    CHECK(huse::contentHash(item, 5) == hashOf(sout.str(), 5));
+
+    item.values.back() = 11;
+    CHECK(huse::contentHash(item) != h);
+    item.values.back() = 10;
+    CHECK(huse::contentHash(item) == h);
+}
+
+struct ItemReordered : public Item
+{
+    void huseSerialize(huse::SerializerNode& n) const
+    {
+        auto o = n.obj();
+        o.val("weight", weight);
+        o.val("name", name);
+        o.val("values", values);
+    }
+};
+
+TEST_CASE("canonical content hash")
+{
+    ItemReordered item;
+    item.name = "huse";
+    item.values = {1, 2, 3};
+    item.weight = 0.5;
+    const Item& base = item;
+
+    CHECK(huse::contentHash(base) != huse::contentHash(item));
+    CHECK(huse::contentHash(base, 0, true) == huse::contentHash(item, 0, true));
+}
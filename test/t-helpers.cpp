@@ -7,9 +7,16 @@
 #include <huse/helpers/Identity.hpp>
 #include <huse/helpers/StdVector.hpp>
 #include <huse/helpers/StdMap.hpp>
+#include <huse/helpers/StdUnorderedMap.hpp>
 #include <huse/helpers/IntAsString.hpp>
+#include <huse/helpers/EnumAsString.hpp>
+#include <huse/helpers/FlatMap.hpp>
+#include <huse/helpers/Columnar.hpp>
+#include <huse/helpers/Borrowed.hpp>
 
 #include <huse/Exception.hpp>
+#include <huse/dom/Serializer.hpp>
+#include <huse/dom/Deserializer.hpp>
 
 #include <doctest/doctest.h>
 
@@ -76,6 +83,73 @@ TEST_CASE("map") {
     std::map<int, std::string> is = {{1, "foo"}, {4, "dsfsd"}, {-5, "boo"}};
     auto isclone = sclone(is);
     CHECK(isclone == is);
+
+    auto iscompact = cclone(is, huse::MapLike{true}, R"({"t":[[-5,"boo"],[1,"foo"],[4,"dsfsd"]]})");
+    CHECK(iscompact == is);
+
+    // both layouts are read in any mode
+    cclone(is, huse::MapLike{}, R"({"t":[{"key":-5,"value":"boo"},{"key":1,"value":"foo"},{"key":4,"value":"dsfsd"}]})");
+    const std::string json = R"({"t":[[2,"two"],[3,"three"]]})";
+    auto d = huse::json::Make_Deserializer(json);
+    ObjWrap<std::map<int, std::string>, huse::MapLike> w(huse::MapLike{});
+    d.root().val(w);
+    CHECK(w.t == std::map<int, std::string>{{2, "two"}, {3, "three"}});
+}
+
+TEST_CASE("map read into") {
+    // all maps read into existing entries and keep the ones which are not in the input
+    auto readInto = [](auto map, const std::string& json) {
+        auto d = huse::json::Make_Deserializer(json);
+        auto root = d.root();
+        root.val(map);
+        return map;
+    };
+    const std::string json = R"({"a":{"x":1},"b":{"y":2}})";
+    using Inner = std::map<std::string, int>;
+
+    std::map<std::string, Inner> plain = {{"a", {{"z", 0}}}, {"c", {}}};
+    CHECK(readInto(plain, json) == std::map<std::string, Inner>{
+        {"a", {{"x", 1}, {"z", 0}}}, {"b", {{"y", 2}}}, {"c", {}}});
+
+    std::map<std::string, Inner, std::less<>> transparent(plain.begin(), plain.end());
+    CHECK(readInto(transparent, json) == std::map<std::string, Inner, std::less<>>{
+        {"a", {{"x", 1}, {"z", 0}}}, {"b", {{"y", 2}}}, {"c", {}}});
+
+    std::unordered_map<std::string, Inner> unordered(plain.begin(), plain.end());
+    CHECK(readInto(unordered, json) == std::unordered_map<std::string, Inner>{
+        {"a", {{"x", 1}, {"z", 0}}}, {"b", {{"y", 2}}}, {"c", {}}});
+
+    std::map<int, Inner> ints = {{1, {{"z", 0}}}, {3, {}}};
+    CHECK(readInto(ints, R"([[1,{"x":1}],[2,{"y":2}]])") == std::map<int, Inner>{
+        {1, {{"x", 1}, {"z", 0}}}, {2, {{"y", 2}}}, {3, {}}});
+    CHECK(readInto(ints, R"([{"key":1,"value":{"x":1}}])") == std::map<int, Inner>{
+        {1, {{"x", 1}, {"z", 0}}}, {3, {}}});
+}
+
+TEST_CASE("flat map duplicates") {
+    // flat maps and maps keep the last of duplicate keys
+    auto read = [](auto& map, const std::string& json, auto f) {
+        auto d = huse::json::Make_Deserializer(json);
+        auto root = d.root();
+        root.cval(map, f);
+    };
+    auto readMap = [](huse::DeserializerNode& n, auto& map) { n.val(map); };
+
+    const std::string ijson = R"([[2,"b"],[1,"a"],[3,"x"],[1,"c"],[2,"d"]])";
+    std::vector<std::pair<int, std::string>> iflat;
+    read(iflat, ijson, huse::FlatMapLike{});
+    std::map<int, std::string> imap;
+    read(imap, ijson, readMap);
+    CHECK(iflat == std::vector<std::pair<int, std::string>>{{1, "c"}, {2, "d"}, {3, "x"}});
+    CHECK(std::vector<std::pair<int, std::string>>(imap.begin(), imap.end()) == iflat);
+
+    const std::string sjson = R"({"b":1,"a":2,"b":3})";
+    std::vector<std::pair<std::string, int>> sflat;
+    read(sflat, sjson, huse::FlatMapLike{});
+    std::map<std::string, int> smap;
+    read(smap, sjson, readMap);
+    CHECK(sflat == std::vector<std::pair<std::string, int>>{{"a", 2}, {"b", 3}});
+    CHECK(std::vector<std::pair<std::string, int>>(smap.begin(), smap.end()) == sflat);
 }
 
 TEST_CASE("istr") {
@@ -102,3 +176,201 @@ TEST_CASE("istr") {
     }
 }
 
+
+enum class Status { Active = 1, Inactive, Deleted, Unknown };
+inline constexpr huse::EnumName<Status> Status_Names[] = {
+    {Status::Active, "ACTIVE"},
+    {Status::Inactive, "INACTIVE"},
+    {Status::Deleted, "DELETED"},
+    {Status::Deleted, "REMOVED"}, // alias
+};
+
+enum Sparse : int { S_Neg = -100, S_Zero = 0, S_Big = 1 << 20 };
+inline constexpr std::array<huse::EnumName<Sparse>, 3> Sparse_Names = {{
+    {S_Big, "big"},
+    {S_Neg, "a \"quoted\" name"},
+    {S_Zero, ""},
+}};
+
+TEST_CASE("enum") {
+    using StatusAsString = huse::EnumAsString<Status_Names>;
+    static_assert(StatusAsString::fromString("INACTIVE") == Status::Inactive);
+    static_assert(StatusAsString::toString(Status::Deleted) == "DELETED");
+    static_assert(!StatusAsString::fromString("inactive"));
+    static_assert(StatusAsString::toString(Status::Unknown).empty());
+
+    CHECK(cclone(Status::Deleted, StatusAsString{}, R"({"t":"DELETED"})") == Status::Deleted);
+    CHECK(cclone(Status::Active, StatusAsString{}) == Status::Active);
+
+    const std::string json = R"({"t":"REMOVED"})";
+    {
+        auto d = huse::json::Make_Deserializer(json);
+        ObjWrap<Status, StatusAsString> w(StatusAsString{});
+        d.root().val(w);
+        CHECK(w.t == Status::Deleted);
+    }
+
+    const std::string unknown = R"({"t":"PENDING"})";
+    {
+        auto d = huse::json::Make_Deserializer(unknown);
+        ObjWrap<Status, StatusAsString> w(StatusAsString{});
+        CHECK_THROWS_WITH_AS(d.root().val(w), R"(root."t" : unknown enum name PENDING)", huse::DeserializerException);
+    }
+    {
+        auto d = huse::json::Make_Deserializer(unknown);
+        ObjWrap<Status, StatusAsString> w(StatusAsString{Status::Unknown});
+        d.root().val(w);
+        CHECK(w.t == Status::Unknown);
+    }
+    CHECK_THROWS_AS(cclone(Status::Unknown, StatusAsString{}), huse::SerializerException);
+
+    // names which need escaping and sparse values
+    using SparseAsString = huse::EnumAsString<Sparse_Names>;
+    CHECK(cclone(S_Neg, SparseAsString{}, R"({"t":"a \"quoted\" name"})") == S_Neg);
+    CHECK(cclone(S_Zero, SparseAsString{}, R"({"t":""})") == S_Zero);
+    CHECK(cclone(S_Big, SparseAsString{}, R"({"t":"big"})") == S_Big);
+    static_assert(!SparseAsString::fromString("small"));
+
+    // canonical serializers don't accept raw json
+    std::ostringstream sout;
+    {
+        huse::json::SerializerOptions opts;
+        opts.canonical = true;
+        auto s = huse::json::Make_Serializer(sout, opts);
+        auto root = s.root();
+        root.cval(Status::Inactive, StatusAsString{});
+    }
+    CHECK(sout.str() == R"("INACTIVE")");
+}
+
+struct Trade {
+    std::string sym;
+    double price = 0;
+    int qty = 0;
+    std::optional<std::string> note;
+
+    bool operator==(const Trade& o) const {
+        return sym == o.sym && price == o.price && qty == o.qty && note == o.note;
+    }
+
+    template <typename Node, typename Self>
+    static void sh(Node& n, Self& s) {
+        auto obj = n.obj();
+        obj.val("sym", s.sym);
+        obj.val("price", s.price);
+        obj.val("qty", s.qty);
+        obj.val("note", s.note);
+    }
+    void huseSerialize(huse::SerializerNode& n) const { sh(n, *this); }
+    void huseDeserialize(huse::DeserializerNode& n) { sh(n, *this); }
+};
+
+TEST_CASE("columns") {
+    std::vector<Trade> trades = {
+        {"ABC", 1.5, 10, {}},
+        {"XYZ", 20, 3, "late"},
+        {"ABC", 1.25, 7, {}},
+    };
+    auto cols = huse::Columns{
+        huse::Column{"sym", &Trade::sym},
+        huse::Column{"price", &Trade::price},
+        huse::Column{"qty", &Trade::qty},
+        huse::Column{"note", &Trade::note},
+    };
+    const std::string json =
+        R"({"t":{"cols":["sym","price","qty","note"],"sym":["ABC","XYZ","ABC"],"price":[1.5,20,1.25],"qty":[10,3,7],"note":[null,"late",null]}})";
+    CHECK(cclone(trades, cols, json) == trades);
+
+    std::vector<Trade> empty;
+    CHECK(cclone(empty, cols, R"({"t":{"cols":["sym","price","qty","note"],"sym":[],"price":[],"qty":[],"note":[]}})").empty());
+
+    // missing optional columns reset the members, unknown columns are ignored
+    {
+        auto d = huse::json::Make_Deserializer(std::string_view(
+            R"({"t":{"cols":["qty","sym","x","price"],"qty":[1,2],"sym":["A","B"],"x":[0,0],"price":[3,4]}})"));
+        ObjWrap<std::vector<Trade>, decltype(cols)> w(trades, cols);
+        d.root().val(w);
+        CHECK(w.t == std::vector<Trade>{{"A", 3, 1, {}}, {"B", 4, 2, {}}});
+    }
+    {
+        auto d = huse::json::Make_Deserializer(std::string_view(R"({"t":{"cols":["sym","qty"],"sym":["A","B"],"qty":[1]}})"));
+        ObjWrap<std::vector<Trade>, decltype(cols)> w(cols);
+        CHECK_THROWS_AS(d.root().val(w), huse::DeserializerException);
+    }
+
+    // no columns in the input: no records
+    {
+        auto notes = huse::Columns{huse::Column{"note", &Trade::note}};
+        auto d = huse::json::Make_Deserializer(std::string_view(R"({"t":{"cols":[]}})"));
+        ObjWrap<std::vector<Trade>, decltype(notes)> w(trades, notes);
+        d.root().val(w);
+        CHECK(w.t.empty());
+    }
+}
+
+struct Tagged {
+    std::string_view name;
+    std::vector<std::string_view> tags;
+
+    template <typename Node, typename Self>
+    static void sh(Node& n, Self& s) {
+        auto obj = n.obj();
+        obj.val("name", s.name);
+        obj.val("tags", s.tags);
+    }
+    void huseSerialize(huse::SerializerNode& n) const { sh(n, *this); }
+    void huseDeserialize(huse::DeserializerNode& n) { sh(n, *this); }
+};
+
+TEST_CASE("borrowed") {
+    huse::Borrowed<Tagged> b;
+    huse::Borrowed<std::string_view> first;
+    {
+        std::string json = R"({"name":"a \"name\"","tags":["x","a long tag which is not in sso"]})";
+        auto d = huse::json::Make_Deserializer(json);
+        d.root().val(b);
+        CHECK(b.ref);
+
+        auto d2 = huse::json::Make_Deserializer(std::string_view(R"(["first","second"])"));
+        auto root = d2.root();
+        auto ar = root.ar();
+        ar.val(first);
+
+        // the views don't point to the input
+        json.assign(json.size(), '#');
+    }
+    CHECK(b->name == "a \"name\"");
+    CHECK(b->tags.size() == 2);
+    CHECK(b->tags[1] == "a long tag which is not in sso");
+    CHECK(*first == "first");
+
+    // the ref is shared by copies
+    auto copy = b;
+    b = {};
+    CHECK(copy->tags[0] == "x");
+
+    std::stringstream sout;
+    {
+        auto s = huse::json::Make_Serializer(sout);
+        s.root().val(copy);
+    }
+    CHECK(sout.str() == R"({"name":"a \"name\"","tags":["x","a long tag which is not in sso"]})");
+
+    // mutable input and doms are owned by the user
+    std::string json = R"(["in place"])";
+    auto d = huse::json::Make_Deserializer(json.data(), json.length());
+    d.root().ar().val(first);
+    CHECK(!first.ref);
+    CHECK(*first == "in place");
+
+    huse::dom::Document doc;
+    {
+        auto s = huse::dom::Make_Serializer(doc);
+        s.root().val(copy);
+    }
+    auto dd = huse::dom::Make_Deserializer(doc);
+    huse::Borrowed<Tagged> fromDom;
+    dd.root().val(fromDom);
+    CHECK(!fromDom.ref);
+    CHECK(fromDom->tags[1] == "a long tag which is not in sso");
+}
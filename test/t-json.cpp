@@ -10,10 +10,18 @@
 #include <huse/helpers/StdVector.hpp>
 
 #include <huse/Exception.hpp>
+#include <huse/Domain.hpp>
+
+#include <dynamix/declare_mixin.hpp>
+#include <dynamix/define_mixin.hpp>
+#include <dynamix/mutate.hpp>
 
 #include <sstream>
 #include <limits>
+#include <climits>
 #include <cstring>
+#include <functional>
+#include <thread>
 
 TEST_SUITE_BEGIN("json");
 
@@ -139,6 +147,30 @@ TEST_CASE("serializer stream")
         s << "sdf";
     }
     CHECK(j.str() == R"("b\n\\g\t\u001bsdf")");
+
+    {
+        // longer than the internal staging buffer, escapes spanning its boundaries
+        auto root = j.compact().root();
+        auto s = root.sstream();
+        for (int i = 0; i < 300; ++i) s << i << '\n';
+        s.get().flush(); // flushing mid-stream is fine
+        s << "\"x\"";
+    }
+    {
+        std::string expected = "\"";
+        for (int i = 0; i < 300; ++i) expected += std::to_string(i) + "\\n";
+        expected += "\\\"x\\\"\"";
+        CHECK(j.str() == expected);
+    }
+
+    {
+        // the stream is reused, but formatting state is not
+        auto root = j.compact().root();
+        auto ar = root.ar();
+        ar.sstream() << std::hex << 255;
+        ar.sstream() << 255;
+    }
+    CHECK(j.str() == R"(["ff","255"])");
 }
 
 TEST_CASE("serializer exceptions")
@@ -174,6 +206,145 @@ TEST_CASE("serializer exceptions")
             huse::SerializerException
         );
     }
+
+    {
+        try
+        {
+            JsonSerializerPack().s->root().val(1ull << 55);
+            CHECK(false);
+        }
+        catch (huse::SerializerException& e)
+        {
+            CHECK(e.code() == huse::ErrorCode::NumberRange);
+        }
+    }
+}
+
+TEST_CASE("serializer raw")
+{
+    {
+        JsonSerializeTester j;
+        {
+            auto root = j.compact().root();
+            auto obj = root.obj();
+            obj.val("a", 1);
+            obj.raw("cached", R"({"x": [1, 2], "y": "z"})");
+            auto ar = obj.ar("ar");
+            ar.raw("1.50");
+            ar.raw("null");
+        }
+        CHECK(j.str() == R"({"a":1,"cached":{"x": [1, 2], "y": "z"},"ar":[1.50,null]})");
+    }
+
+#if !defined(NDEBUG)
+    {
+        JsonSerializerPack p;
+        auto root = p.s->root();
+        auto ar = root.ar();
+        CHECK_THROWS_WITH_AS(ar.raw("{"), "Invalid raw json", huse::SerializerException);
+        CHECK_THROWS_WITH_AS(ar.raw("1, 2"), "Invalid raw json", huse::SerializerException);
+    }
+#endif
+}
+
+TEST_CASE("canonical serialize")
+{
+    auto canonical = [](auto write) {
+        std::ostringstream sout;
+        {
+            huse::json::SerializerOptions opts;
+            opts.canonical = true;
+            opts.pretty = true; // ignored
+            auto s = huse::json::Make_Serializer(sout, opts);
+            auto root = s.root();
+            write(root);
+        }
+        return sout.str();
+    };
+
+    CHECK(canonical([](huse::SerializerNode& n) {
+        auto obj = n.obj();
+        obj.val("b", 1);
+        obj.val("a", true);
+        {
+            auto inner = obj.obj("c");
+            inner.val("z", "z");
+            auto ar = inner.ar("y");
+            ar.val(2);
+            {
+                auto o = ar.obj();
+                o.val("q", 1);
+                o.val("p", 2);
+            }
+            ar.obj();
+        }
+        obj.sstream("aa") << "x" << 1;
+        obj.obj("");
+    }) == R"({"":{},"a":true,"aa":"x1","b":1,"c":{"y":[2,{"p":2,"q":1},{}],"z":"z"}})");
+
+    // RFC 8785 3.2.3: sorting by utf-16 code units
+    CHECK(canonical([](huse::SerializerNode& n) {
+        auto obj = n.obj();
+        obj.val("\xE2\x82\xAC", "Euro Sign");
+        obj.val("\r", "Carriage Return");
+        obj.val("\xEF\xAC\xB3", "Hebrew Letter Dalet With Dagesh");
+        obj.val("1", "One");
+        obj.val("\xF0\x9F\x98\x80", "Emoji: Grinning Face");
+        obj.val("\xC2\x80", "Control");
+        obj.val("\xC3\xB6", "Latin Small Letter O With Diaeresis");
+    }) == "{\"\\r\":\"Carriage Return\",\"1\":\"One\",\"\xC2\x80\":\"Control\","
+        "\"\xC3\xB6\":\"Latin Small Letter O With Diaeresis\",\"\xE2\x82\xAC\":\"Euro Sign\","
+        "\"\xF0\x9F\x98\x80\":\"Emoji: Grinning Face\",\"\xEF\xAC\xB3\":\"Hebrew Letter Dalet With Dagesh\"}");
+
+    // RFC 8785 3.2.2.3: numbers
+    auto num = [&](double d) {
+        return canonical([d](huse::SerializerNode& n) { n.val(d); });
+    };
+    CHECK(num(0) == "0");
+    CHECK(num(-0.0) == "0");
+    CHECK(num(4.50) == "4.5");
+    CHECK(num(2e-3) == "0.002");
+    CHECK(num(0.000001) == "0.000001");
+    CHECK(num(1e-7) == "1e-7");
+    CHECK(num(123e-20) == "1.23e-18");
+    CHECK(num(1e20) == "100000000000000000000");
+    CHECK(num(1e21) == "1e+21");
+    CHECK(num(1e30) == "1e+30");
+    CHECK(num(-1.5e300) == "-1.5e+300");
+    CHECK(num(333333333.33333329) == "333333333.3333333");
+    CHECK(num(9007199254740992.) == "9007199254740992");
+    CHECK(num(5e-324) == "5e-324");
+    CHECK(num(1.7976931348623157e308) == "1.7976931348623157e+308");
+    CHECK(num(-123.456) == "-123.456");
+
+    // raw json is canonicalized too
+    CHECK(canonical([](huse::SerializerNode& n) {
+        auto ar = n.ar();
+        ar.raw(R"({"y": [1.50, {"b": null, "a": 1E2}], "x": "z"})");
+        ar.raw("1.0");
+    }) == R"([{"x":"z","y":[1.5,{"a":100,"b":null}]},1])");
+
+    // deep nesting: each object is sorted in place and written once
+    constexpr int Depth = 2000;
+    std::function<void(huse::SerializerObject&, int)> nest = [&](huse::SerializerObject& obj, int i) {
+        obj.val("z", i);
+        if (i == Depth) return;
+        {
+            auto inner = obj.obj("b");
+            nest(inner, i + 1);
+        }
+        auto ar = obj.ar("a");
+        ar.obj().val("y", i);
+        ar.obj();
+    };
+    std::string expected;
+    for (int i = 0; i < Depth; ++i) expected += R"({"a":[{"y":)" + std::to_string(i) + R"(},{}],"b":)";
+    expected += R"({"z":2000})";
+    for (int i = Depth - 1; i >= 0; --i) expected += R"(,"z":)" + std::to_string(i) + "}";
+    CHECK(canonical([&](huse::SerializerNode& n) {
+        auto obj = n.obj();
+        nest(obj, 0);
+    }) == expected);
 }
 
 huse::Deserializer makeD(std::string_view str)
@@ -295,8 +466,127 @@ TEST_CASE("stream deserialize")
     }
 }
 
+TEST_CASE("scanner deserialize")
+{
+    auto d = makeD(R"json({"string":"aa bbb c", "nums":" -12 3.5\t7 1 x", "vec":"(3; -4)", "bad":"1.5"})json");
+    auto root = d.root();
+    auto o = root.obj();
+    CHECK(!o.optscanner("asdf"));
+    CHECK(!!o.optscanner("string"));
+
+    {
+        std::string a;
+        std::string_view b, c, e;
+        o.scanner("string") >> a >> b >> c >> e;
+        CHECK(a == "aa");
+        CHECK(b == "bbb");
+        CHECK(c == "c");
+        CHECK(e.empty());
+    }
+
+    {
+        int i;
+        float f;
+        unsigned u;
+        bool b;
+        char x;
+        auto s = o.scanner("nums");
+        s >> i >> f >> u >> b;
+        CHECK(i == -12);
+        CHECK(f == 3.5f);
+        CHECK(u == 7);
+        CHECK(b);
+        CHECK(!s.eof());
+        s >> x;
+        CHECK(x == 'x');
+        CHECK(s.eof());
+    }
+
+    {
+        int x, y;
+        auto s = o.scanner("vec");
+        s.expect('(') >> x;
+        s.expect(';') >> y;
+        CHECK(!s.skip(','));
+        CHECK(s.skip(')'));
+        CHECK(x == 3);
+        CHECK(y == -4);
+        CHECK(s.eof());
+    }
+
+    {
+        int i;
+        auto s = o.scanner("bad");
+        s >> i;
+        CHECK(i == 1);
+        CHECK(s.rest() == ".5");
+        CHECK_THROWS_WITH_AS(s >> i, R"(root."bad" : not a number)", huse::DeserializerException);
+        CHECK_THROWS_WITH_AS(s.expect(']'), R"(root."bad" : expected ']')", huse::DeserializerException);
+    }
+}
+
 #define CHECK_THROWS_D(e, txt) CHECK_THROWS_WITH_AS(e, txt, huse::DeserializerException)
 
+TEST_CASE("deserializer raw")
+{
+    constexpr std::string_view json = R"json({
+        "num": 1.50,
+        "str": "a\"b",
+        "ar": [ 1, {"x": [ 2 ]} , "]" ],
+        "obj": { "y" : null }
+    })json";
+
+    huse::json::DeserializerOptions opts;
+    opts.retainSource = true;
+
+    {
+        auto d = huse::json::Make_Deserializer(json, opts);
+        auto root = d.root();
+        auto obj = root.obj();
+        CHECK(obj.raw("str") == R"("a\"b")");
+        CHECK(obj.raw("num") == "1.50");
+        CHECK(obj.raw("obj") == R"({ "y" : null })");
+        {
+            auto ar = obj.ar("ar");
+            int i;
+            ar.val(i); // regular reads and raw can be mixed
+            CHECK(i == 1);
+            CHECK(ar.raw() == R"({"x": [ 2 ]})");
+            CHECK(ar.raw() == R"("]")");
+            CHECK(ar.index(0).raw() == "1");
+            CHECK(ar.index(2).raw() == R"("]")");
+        }
+        {
+            auto ar = obj.ar("ar");
+            ar.index(1);
+            auto o = ar.obj();
+            auto x = o.ar("x");
+            CHECK(x.raw() == "2");
+        }
+    }
+
+    {
+        auto d = huse::json::Make_Deserializer(json, opts);
+        CHECK(d.root().raw() == json);
+    }
+
+    {
+        // raw from a backend without a source
+        auto d = makeD(json);
+        auto root = d.root();
+        auto obj = root.obj();
+        try
+        {
+            obj.raw("num");
+            CHECK(false);
+        }
+        catch (huse::DeserializerException& e)
+        {
+            CHECK(e.code() == huse::ErrorCode::Unsupported);
+        }
+    }
+}
+
 TEST_CASE("deserialize iteration")
 {
     {
@@ -346,6 +636,371 @@ TEST_CASE("deserialize iteration")
     }
 }
 
+TEST_CASE("key shape")
+{
+    huse::KeyShape shape;
+    auto read = [&](huse::DeserializerNode& n) {
+        auto o = n.obj();
+        o.shape(shape);
+        int a, b, c = 0;
+        o.val("a", a);
+        o.val("b", b);
+        o.optval("c", c);
+        return a * 100 + b * 10 + c;
+    };
+
+    auto d = huse::json::Make_Deserializer(std::string_view(R"([
+        {"a": 1, "b": 2, "c": 3},
+        {"a": 4, "b": 5, "c": 6},
+        {"c": 9, "b": 8, "a": 7},
+        {"b": 2, "a": 1}
+    ])"));
+    auto root = d.root();
+    auto ar = root.ar();
+
+    CHECK(read(ar.index(0)) == 123);
+    REQUIRE(shape.size() == 3);
+    CHECK(shape[0] == 0);
+    CHECK(shape[2] == 2);
+
+    CHECK(read(ar.index(1)) == 456);
+    CHECK(shape[1] == 1);
+
+    // relearn
+    CHECK(read(ar.index(2)) == 789);
+    CHECK(shape[0] == 2);
+    CHECK(shape[1] == 1);
+    CHECK(shape[2] == 0);
+
+    CHECK(read(ar.index(3)) == 120);
+    CHECK(shape[0] == 1);
+    CHECK(shape[1] == 0);
+
+    // shapes must not hide missing keys
+    auto d2 = huse::json::Make_Deserializer(std::string_view(R"({"x": 1})"));
+    auto root2 = d2.root();
+    CHECK_THROWS_AS(read(root2), huse::DeserializerException);
+}
+
+TEST_CASE("deserializer bookmarks")
+{
+    auto d = huse::json::Make_Deserializer(std::string_view(R"([
+        {"r": 2, "type": "circle"},
+        {"w": 3, "h": 4, "type": "rect"}
+    ])"));
+    auto root = d.root();
+    auto ar = root.ar();
+
+    std::vector<int> areas;
+    while (auto q = ar.peeknext())
+    {
+        // the discriminator is last, so read the element twice
+        auto bm = q->bookmark();
+        std::string type;
+        {
+            auto o = q->obj();
+            o.val("type", type);
+        }
+        q->restore(bm);
+
+        auto o = q->obj();
+        if (type == "circle")
+        {
+            int r;
+            o.val("r", r);
+            areas.push_back(3 * r * r);
+        }
+        else
+        {
+            int w, h;
+            o.val("w", w);
+            o.val("h", h);
+            areas.push_back(w * h);
+        }
+    }
+    CHECK(areas == std::vector<int>{12, 12});
+
+    // iterate an object twice
+    auto d2 = huse::json::Make_Deserializer(std::string_view(R"({"a": 1, "b": {"c": 2}})"));
+    auto root2 = d2.root();
+    auto o = root2.obj();
+    auto bm = o.bookmark();
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        std::string keys;
+        while (auto q = o.peeknext())
+        {
+            keys += q.name;
+            q->skip();
+        }
+        CHECK(keys == "ab");
+        o.restore(bm);
+    }
+
+    // bookmarks of other nodes
+    auto d3 = huse::json::Make_Deserializer(std::string_view(R"([[1, 2], [3, 4]])"));
+    auto root3 = d3.root();
+    auto ar3 = root3.ar();
+    huse::DeserializerBookmark inFirst;
+    {
+        auto a = ar3.ar();
+        inFirst = a.bookmark();
+        int i;
+        a.val(i);
+        CHECK(i == 1);
+        // another deserializer
+        CHECK_THROWS_AS(a.restore(bm), huse::DeserializerException);
+        a.restore(inFirst);
+        a.val(i);
+        CHECK(i == 1);
+    }
+    {
+        // same depth, different compound
+        auto a = ar3.ar();
+        CHECK_THROWS_AS(a.restore(inFirst), huse::DeserializerException);
+    }
+}
+
+TEST_CASE("projection")
+{
+    huse::json::Projection proj({"/id", "/items/*/a", "/big/deep/2", "/items/1/b", "/~1odd~0"});
+
+    huse::json::DeserializerOptions opts;
+    opts.projection = &proj;
+
+    auto d = huse::json::Make_Deserializer(std::string_view(R"({
+        "id": 1,
+        "name": "skipped \u0041",
+        "big": {"deep": [1.5e10, [2, {}], {"a": "x\ty"}], "other": null},
+        "items": [{"a": 1, "b": 2}, {"a": 3, "b": 4}],
+        "/odd~": true
+    })"), opts);
+
+    auto root = d.root();
+    auto o = root.obj();
+
+    int i;
+    o.val("id", i);
+    CHECK(i == 1);
+    CHECK_FALSE(o.optkey("name"));
+
+    bool b;
+    o.val("/odd~", b);
+    CHECK(b);
+
+    {
+        auto items = o.ar("items");
+        CHECK(items.length() == 2);
+        {
+            auto item = items.obj();
+            item.val("a", i);
+            CHECK(i == 1);
+            CHECK_FALSE(item.optkey("b"));
+        }
+        {
+            auto item = items.obj();
+            item.val("a", i);
+            CHECK(i == 3);
+            item.val("b", i);
+            CHECK(i == 4);
+        }
+    }
+
+    {
+        auto big = o.obj("big");
+        CHECK_FALSE(big.optkey("other"));
+        auto deep = big.ar("deep");
+        CHECK(deep.length() == 3);
+        // skipped elements keep their place as null
+        CHECK(deep.type().is(huse::Type::Array));
+        CHECK(deep.peeknext()->type().is(huse::Type::Null));
+        deep.skip();
+        deep.skip();
+        std::string_view str;
+        deep.obj().val("a", str);
+        CHECK(str == "x\ty");
+    }
+
+    // skipped parts are still validated
+    auto expectSyntax = [&](std::string_view json) {
+        try
+        {
+            huse::json::Make_Deserializer(json, opts);
+            CHECK(false);
+        }
+        catch (huse::DeserializerException& e)
+        {
+            CHECK(e.code() == huse::ErrorCode::Syntax);
+        }
+    };
+    expectSyntax(R"({"name": [1, 2,], "id": 1})");
+    expectSyntax(R"({"name": 01, "id": 1})");
+    expectSyntax(R"({"name": 1.e5, "id": 1})");
+    expectSyntax(R"({"name": "\x", "id": 1})");
+    expectSyntax(R"({"name": {"a" 1}, "id": 1})");
+    expectSyntax(R"({"name": [1 2], "id": 1})");
+
+    CHECK_THROWS_AS(huse::json::Projection({"a/b"}), huse::Exception);
+}
+
+TEST_CASE("json pointer")
+{
+    std::string_view json = R"({
+        "services": [
+            {"name": "a", "limits": {"cpu": 1}},
+            {"name": "b", "limits": {"cpu": 2, "mem": [5, 6]}}
+        ],
+        "a/b": {"~": "tilde"}
+    })";
+    auto d = huse::json::Make_Deserializer(json, {true, true});
+
+    int i;
+    d.at("/services/1/limits/cpu").val(i);
+    CHECK(i == 2);
+
+    {
+        auto node = d.at("/services/1/limits");
+        auto o = node.obj();
+        o.val("cpu", i);
+        CHECK(i == 2);
+        auto mem = o.ar("mem");
+        mem.index(1).val(i);
+        CHECK(i == 6);
+    }
+
+    std::string_view str;
+    d.at("/a~1b/~0").val(str);
+    CHECK(str == "tilde");
+
+    CHECK(d.at("/services/0").raw() == R"({"name": "a", "limits": {"cpu": 1}})");
+    CHECK(d.at("/services/1/limits/mem").raw() == "[5, 6]");
+
+    // back to the document root
+    {
+        auto root = d.root();
+        auto o = root.obj();
+        CHECK(o.optkey("services"));
+    }
+
+    // compiled pointers can be reused
+    huse::JsonPointer cpu("/services/0/limits/cpu");
+    CHECK(cpu.size() == 4);
+    CHECK(cpu[1].index == 0);
+    CHECK(cpu[0].index == size_t(-1));
+    for (int n = 0; n < 2; ++n)
+    {
+        auto dn = huse::json::Make_Deserializer(json);
+        dn.at(cpu).val(i);
+        CHECK(i == 1);
+    }
+
+    try
+    {
+        d.at("/services/5/name");
+        CHECK(false);
+    }
+    catch (huse::DeserializerException& e)
+    {
+        CHECK(e.code() == huse::ErrorCode::OutOfRange);
+        CHECK(std::string_view(e.what()) == "/services/5/name : out of range");
+    }
+
+    try
+    {
+        d.at("/services/0").val(i);
+        CHECK(false);
+    }
+    catch (huse::DeserializerException& e)
+    {
+        CHECK(e.code() == huse::ErrorCode::TypeMismatch);
+        CHECK(std::string_view(e.what()) == "/services/0 : not an integer");
+    }
+
+    CHECK_THROWS_AS(huse::JsonPointer("services"), huse::DeserializerException);
+    CHECK_THROWS_AS(huse::JsonPointer("/a~2"), huse::DeserializerException);
+    CHECK(huse::JsonPointer("/01")[0].index == size_t(-1));
+}
+
+// a backend with a virtual array which is too big to parse in a test
+// element i is i % 1000
+DYNAMIX_DECLARE_MIXIN(struct HugeArray);
+struct HugeArray
+{
+    size_t length;
+    bool open = false;
+    size_t pending = 0;
+
+    HugeArray(size_t len) : length(len) {}
+
+    [[noreturn]] void throwOutOfRange(size_t index) const
+    {
+        huse::DeserializerException ex(huse::ErrorCode::OutOfRange, "out of range");
+        ex.appendPath("root", 0);
+        ex.appendPath({}, index);
+        throw ex;
+    }
+
+    void loadIndex(size_t index)
+    {
+        if (index >= length) throwOutOfRange(index);
+        pending = index;
+    }
+
+    template <typename T>
+    void read(T& val)
+    {
+        if (pending >= length) throwOutOfRange(pending);
+        val = T(pending++ % 1000);
+    }
+};
+
+DYNAMIX_DEFINE_MIXIN(huse::Domain, HugeArray)
+    .implements_by<huse::loadArray_msg>([](HugeArray* a) { a->open = true; })
+    .implements_by<huse::unloadArray_msg>([](HugeArray* a) { a->open = false; })
+    .implements_by<huse::curLength_msg>([](const HugeArray* a) { return a->open ? a->length : size_t(1); })
+    .implements_by<huse::loadIndex_msg>([](HugeArray* a, size_t index) { a->loadIndex(index); })
+    .implements_by<huse::husePolyDeserialize_int>([](HugeArray* a, int& val) { a->read(val); })
+;
+
+TEST_CASE("huge array")
+{
+    if constexpr (sizeof(size_t) > 4)
+    {
+        const size_t size = (size_t(1) << 32) + 3;
+
+        huse::Deserializer d;
+        dynamix::mutate(d, dynamix::add<HugeArray>(size));
+        auto root = d.root();
+        auto ar = root.ar();
+        static_assert(std::is_same_v<decltype(ar.length()), size_t>);
+        CHECK(ar.length() == size);
+
+        int i;
+        ar.index(size - 1).val(i);
+        CHECK(i == int((size - 1) % 1000));
+        ar.index(size_t(INT_MAX) + 5).val(i);
+        CHECK(i == int((size_t(INT_MAX) + 5) % 1000));
+
+        try
+        {
+            ar.index(size);
+            CHECK(false);
+        }
+        catch (huse::DeserializerException& e)
+        {
+            CHECK(e.pathElement(1).index == size);
+            CHECK(std::string(e.what()) == "root.[4294967299] : out of range");
+        }
+    }
+
+    // the json backend reports indices above INT_MAX in paths
+    auto d = huse::json::Make_Deserializer(std::string_view("[1, 2]"));
+    auto root = d.root();
+    auto ar = root.ar();
+    const size_t big = size_t(INT_MAX) + 1;
+    CHECK_THROWS_WITH_AS(ar.index(big), "root.[2147483648] : out of range", huse::DeserializerException);
+}
+
 TEST_CASE("deserializer exceptions")
 {
     {
@@ -439,6 +1094,100 @@ TEST_CASE("deserializer exceptions")
     }
 }
 
+TEST_CASE("deserializer exception data")
+{
+    auto getEx = [](std::string_view json, auto func) {
+        // the exception outlives the deserializer
+        try
+        {
+            auto d = makeD(json);
+            func(d);
+        }
+        catch (huse::DeserializerException& e)
+        {
+            return e;
+        }
+        return huse::DeserializerException("no exception");
+    };
+
+    {
+        auto e = getEx("{", [](huse::Deserializer&) {});
+        CHECK(e.code() == huse::ErrorCode::Syntax);
+        CHECK(e.pathLength() == 0);
+        CHECK(std::string_view(e.what()) == e.message());
+    }
+    {
+        auto e = getEx(R"({"ar": [1, {"xyz": "5"}]})", [](huse::Deserializer& d) {
+            int i;
+            d.root().obj().ar("ar").index(1).obj().val("xyz", i);
+        });
+        CHECK(e.code() == huse::ErrorCode::TypeMismatch);
+        CHECK(std::string_view(e.message()) == "not an integer");
+        REQUIRE(e.pathLength() == 4);
+        CHECK(e.pathElement(0).key == "root");
+        CHECK(e.pathElement(1).key == "ar");
+        CHECK(e.pathElement(2).key.empty());
+        CHECK(e.pathElement(2).index == 1);
+        CHECK(e.pathElement(3).key == "xyz");
+        CHECK(std::string_view(e.what()) == R"(root."ar".[1]."xyz" : not an integer)");
+
+        auto copy = e;
+        CHECK(copy.pathElement(3).key == "xyz");
+        CHECK(std::string_view(copy.what()) == e.what());
+    }
+    {
+        // a shared exception formatted by several threads at once
+        std::exception_ptr ep;
+        try
+        {
+            auto d = makeD(R"({"ar": [1, {"xyz": "5"}]})");
+            int i;
+            d.root().obj().ar("ar").index(1).obj().val("xyz", i);
+        }
+        catch (huse::DeserializerException&)
+        {
+            ep = std::current_exception();
+        }
+        REQUIRE(ep);
+
+        std::vector<std::string> texts(4);
+        std::vector<std::thread> threads;
+        for (auto& text : texts)
+        {
+            threads.emplace_back([&]() {
+                try
+                {
+                    std::rethrow_exception(ep);
+                }
+                catch (const huse::DeserializerException& e)
+                {
+                    text = e.what();
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+        for (auto& text : texts) CHECK(text == R"(root."ar".[1]."xyz" : not an integer)");
+    }
+    {
+        auto e = getEx(R"([1, 2])", [](huse::Deserializer& d) {
+            d.root().ar().index(2);
+        });
+        CHECK(e.code() == huse::ErrorCode::OutOfRange);
+        CHECK(e.pathLength() == 2);
+    }
+    {
+        auto e = getEx(R"([1, 2])", [](huse::Deserializer& d) {
+            auto root = d.root();
+            auto ar = root.ar();
+            int i;
+            ar.index(1).val(i);
+            ar.throwException("custom");
+        });
+        CHECK(e.code() == huse::ErrorCode::User);
+        CHECK(std::string_view(e.what()) == "root.[1] : custom");
+    }
+}
+
 TEST_CASE("string i/o")
 {
     std::string zeroStart = "0starts with zero";
@@ -641,6 +1390,105 @@ TEST_CASE("struct i/o")
     CHECK(scc == src.a);
 }
 
+struct Positive
+{
+    int value = 0;
+
+    void huseDeserialize(huse::DeserializerNode& n)
+    {
+        n.val(value);
+        if (value <= 0) n.throwException("not positive");
+    }
+};
+
+TEST_CASE("deserializer error state")
+{
+    huse::json::DeserializerOptions opts;
+    opts.throwOnError = false;
+
+    auto makeND = [&](std::string_view str) {
+        return huse::json::Make_Deserializer(str, opts);
+    };
+
+    {
+        auto d = makeND(R"({"a": {"x": 5, "y": "abc", "z": 1.5}, "b": 7})");
+        ComplexTest ct = {};
+        auto r = d.tryVal(ct);
+        CHECK(r);
+        CHECK(r.code() == huse::ErrorCode::None);
+        CHECK(r.text().empty());
+        CHECK(ct.a.x == 5);
+        CHECK(ct.a.y == "abc");
+        CHECK(ct.b == 7);
+    }
+    {
+        auto d = makeND(R"({"a": {"x": "5", "y": "abc", "z": 1.5}, "b": 7})");
+        ComplexTest ct = {{1, "q", 2}, 3};
+        auto r = d.tryVal(ct);
+        CHECK_FALSE(r);
+        CHECK(r.code() == huse::ErrorCode::TypeMismatch);
+        CHECK(r.text() == R"(root."a"."x" : not an integer)");
+        // nothing after the error is read
+        CHECK(ct.a.x == 1);
+        CHECK(ct.a.y == "q");
+        CHECK(ct.b == 3);
+    }
+    {
+        auto d = makeND(R"({"a": {"x": 5, "z": 1.5}, "b": 7})");
+        ComplexTest ct = {};
+        auto r = d.tryVal(ct);
+        CHECK(r.code() == huse::ErrorCode::OutOfRange);
+        CHECK(r.text() == R"(root."a"."y" : out of range)");
+    }
+    {
+        auto d = makeND("[1, 2, -3]");
+        std::vector<uint32_t> vec;
+        auto r = d.tryVal(vec);
+        CHECK(r.code() == huse::ErrorCode::NumberRange);
+        CHECK(r.text() == "root.[2] : negative integer");
+    }
+    {
+        // the result can outlive the deserializer
+        auto r = [&]() {
+            auto d = makeND("[1, -2]");
+            std::vector<uint32_t> vec;
+            return d.tryVal(vec);
+        }();
+        CHECK(r.code() == huse::ErrorCode::NumberRange);
+        CHECK(r.text() == "root.[1] : negative integer");
+    }
+    {
+        auto d = makeND("{");
+        CHECK(huse::errorCode_msg::call(d) == huse::ErrorCode::Syntax);
+        ComplexTest ct = {};
+        auto r = d.tryVal(ct);
+        CHECK(r.code() == huse::ErrorCode::Syntax);
+        CHECK_FALSE(r.text().empty());
+    }
+    {
+        auto d = makeND("[3, -4]");
+        std::vector<Positive> vec;
+        auto r = d.tryVal(vec);
+        CHECK(r.code() == huse::ErrorCode::User);
+        CHECK(r.text() == "root.[1] : not positive");
+    }
+    {
+        // recorded errors take precedence over what user code throws afterwards
+        auto d = makeND("[-4");
+        std::vector<Positive> vec;
+        auto r = d.tryVal(vec);
+        CHECK(r.code() == huse::ErrorCode::Syntax);
+    }
+    {
+        // default mode still throws, but tryVal catches
+        auto d = makeD(R"({"a": 5})");
+        ComplexTest ct = {};
+        auto r = d.tryVal(ct);
+        CHECK(r.code() == huse::ErrorCode::TypeMismatch);
+        CHECK(r.text() == R"(root."a" : not an object)");
+    }
+}
+
 TEST_CASE("std::vector i/o")
 {
     const std::vector<ComplexTest> src = {
@@ -0,0 +1,164 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include <doctest/doctest.h>
+
+#include <huse/Lazy.hpp>
+#include <huse/json/Serializer.hpp>
+#include <huse/json/Deserializer.hpp>
+#include <huse/dom/Serializer.hpp>
+#include <huse/dom/Deserializer.hpp>
+
+#include <sstream>
+#include <string>
+
+TEST_SUITE_BEGIN("lazy");
+
+struct Metadata
+{
+    std::string author;
+    int revision = 0;
+
+    template <typename N, typename Self>
+    static void serializeT(N& n, Self& self)
+    {
+        auto o = n.obj();
+        o.val("author", self.author);
+        o.val("revision", self.revision);
+    }
+
+    void huseSerialize(huse::SerializerNode& n) const { serializeT(n, *this); }
+    void huseDeserialize(huse::DeserializerNode& n) { serializeT(n, *this); }
+};
+
+struct Request
+{
+    int id = 0;
+    huse::Lazy<Metadata> metadata;
+    huse::Lazy<int> count;
+
+    template <typename N, typename Self>
+    static void serializeT(N& n, Self& self)
+    {
+        auto o = n.obj();
+        o.val("id", self.id);
+        o.val("metadata", self.metadata);
+        o.val("count", self.count);
+    }
+
+    void huseSerialize(huse::SerializerNode& n) const { serializeT(n, *this); }
+    void huseDeserialize(huse::DeserializerNode& n) { serializeT(n, *this); }
+};
+
+std::string toJson(const Request& r)
+{
+    std::ostringstream sout;
+    huse::json::Make_Serializer(sout).root().val(r);
+    return sout.str();
+}
+
+TEST_CASE("lazy json")
+{
+    std::string_view json = R"({"id": 3, "metadata": { "author" : "joe",  "revision": 7 }, "count": 12})";
+
+    Request r;
+    {
+        auto d = huse::json::Make_Deserializer(json, {true, true});
+        d.root().val(r);
+    }
+
+    CHECK(r.id == 3);
+    CHECK_FALSE(r.metadata.loaded());
+    CHECK(r.metadata.json() == R"({ "author" : "joe",  "revision": 7 })");
+    CHECK_FALSE(r.count.loaded());
+
+    // untouched values are written verbatim
+    CHECK(toJson(r) == R"({"id":3,"metadata":{ "author" : "joe",  "revision": 7 },"count":12})");
+
+    CHECK(r.metadata->author == "joe");
+    CHECK(r.metadata->revision == 7);
+    CHECK(r.metadata.loaded());
+    CHECK(r.metadata.json().empty());
+    CHECK(*r.count == 12);
+
+    r.metadata->revision = 8;
+    r.count = 13;
+    CHECK(toJson(r) == R"({"id":3,"metadata":{"author":"joe","revision":8},"count":13})");
+
+    // without a retained source
+    {
+        std::string str(json);
+        auto d = huse::json::Make_Deserializer(str);
+        str.clear(); // the deserializer has its own copy
+        d.root().val(r);
+    }
+    CHECK_FALSE(r.metadata.loaded());
+    CHECK(r.metadata.json().empty());
+    // the detached values keep the document alive
+    CHECK(toJson(r) == R"({"id":3,"metadata":{"author":"joe","revision":7},"count":12})");
+    CHECK(r.metadata->author == "joe");
+    CHECK(*r.count == 12);
+
+    // default constructed
+    Request e;
+    CHECK(toJson(e) == R"({"id":0,"metadata":{"author":"","revision":0},"count":0})");
+}
+
+TEST_CASE("lazy dom")
+{
+    huse::dom::Document doc;
+    {
+        auto s = huse::dom::Make_Serializer(doc);
+        auto root = s.root();
+        auto o = root.obj();
+        o.val("id", 5);
+        {
+            auto m = o.obj("metadata");
+            m.val("author", "ann");
+            m.val("revision", 2);
+        }
+        o.val("count", "many");
+    }
+
+    Request r;
+    {
+        auto d = huse::dom::Make_Deserializer(doc);
+        d.root().val(r);
+    }
+
+    // no raw json in the dom, so values are transcoded from the document
+    CHECK(r.metadata.json().empty());
+    CHECK(toJson(r) == R"({"id":5,"metadata":{"author":"ann","revision":2},"count":"many"})");
+
+    CHECK(r.metadata->author == "ann");
+    CHECK(r.metadata->revision == 2);
+
+    // errors are deferred as well
+    CHECK_THROWS_AS(r.count.get(), huse::DeserializerException);
+}
+
+TEST_CASE("detach")
+{
+    huse::DetachedValue dv;
+    huse::DocumentRef ref;
+    std::string_view name;
+    {
+        auto d = huse::json::Make_Deserializer(std::string(R"({"a": {"name": "x\ty", "ar": [1, 2]}, "b": 3})"));
+        auto root = d.root();
+        auto o = root.obj();
+        dv = o.key("a").detach();
+        // refs still work after the document is shared
+        ref = o.key("b").documentRef();
+        CHECK(ref);
+        CHECK(dv.source().empty());
+    }
+    REQUIRE(dv);
+
+    auto d = dv.deserializer();
+    auto root = d.root();
+    auto o = root.obj();
+    o.val("name", name);
+    CHECK(name == "x\ty");
+    auto a = o.ar("ar");
+    CHECK(a.length() == 2);
+}
@@ -0,0 +1,143 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include <doctest/doctest.h>
+
+#include <huse/StringPool.hpp>
+#include <huse/json/Serializer.hpp>
+#include <huse/json/Deserializer.hpp>
+#include <huse/helpers/StdVector.hpp>
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_SUITE_BEGIN("string pool");
+
+TEST_CASE("string pool basic")
+{
+    huse::StringPool pool(4);
+
+    auto a = pool.intern("ACTIVE");
+    std::string str = "ACTIVE";
+    auto b = pool.intern(str);
+    auto c = pool.intern("INACTIVE");
+
+    CHECK(a == b);
+    CHECK(a != c);
+    CHECK(a.str() == "ACTIVE");
+    CHECK(a.str().data() == b.str().data());
+    CHECK(c.str() == "INACTIVE");
+
+    CHECK(pool.find("ACTIVE") == a);
+    CHECK(pool.find("DELETED").empty());
+
+    CHECK(pool.intern("").empty());
+    CHECK(pool.intern("") == huse::InternedString{});
+
+    std::string big(huse::StringPool::Block_Size, 'x');
+    auto d = pool.intern(big);
+    CHECK(d.str() == big);
+    CHECK(pool.intern(big) == d);
+
+    auto stats = pool.stats();
+    CHECK(stats.strings == 3);
+    CHECK(stats.misses == 3);
+    CHECK(stats.hits == 3);
+    CHECK(stats.bytes == 14 + big.size());
+    CHECK(stats.allocatedBytes >= stats.bytes);
+
+    // handles from different pools are different
+    huse::StringPool other;
+    CHECK(other.intern("ACTIVE") != a);
+}
+
+struct Account
+{
+    std::string name;
+    huse::InternedString status;
+    huse::InternedString country;
+
+    template <typename Node, typename Self>
+    static void sh(Node& n, Self& s)
+    {
+        auto obj = n.obj();
+        obj.val("name", s.name);
+        obj.val("status", s.status);
+        obj.val("country", s.country);
+    }
+    void huseSerialize(huse::SerializerNode& n) const { sh(n, *this); }
+    void huseDeserialize(huse::DeserializerNode& n) { sh(n, *this); }
+};
+
+TEST_CASE("interned serialize")
+{
+    auto json = R"([{"name":"a","status":"ACTIVE","country":"BG"},{"name":"b","status":"ACTIVE","country":""}])";
+
+    std::vector<Account> accounts;
+    {
+        auto d = huse::json::Make_Deserializer(std::string_view(json));
+        d.root().val(accounts);
+    }
+    REQUIRE(accounts.size() == 2);
+    CHECK(accounts[0].status == accounts[1].status);
+    CHECK(accounts[0].status == huse::StringPool::global().find("ACTIVE"));
+    CHECK(accounts[0].country.str() == "BG");
+    CHECK(accounts[1].country.empty());
+
+    std::ostringstream sout;
+    {
+        auto s = huse::json::Make_Serializer(sout);
+        s.root().val(accounts);
+    }
+    CHECK(sout.str() == json);
+
+    // explicit pool
+    huse::StringPool pool;
+    huse::InternedString status;
+    {
+        auto d = huse::json::Make_Deserializer(std::string_view(R"({"status":"DELETED"})"));
+        auto root = d.root();
+        auto obj = root.obj();
+        obj.cval("status", status, huse::Interned{pool});
+    }
+    CHECK(status == pool.find("DELETED"));
+    CHECK(huse::StringPool::global().find("DELETED").empty());
+}
+
+TEST_CASE("string pool threads")
+{
+    huse::StringPool pool;
+
+    constexpr int Num_Threads = 4;
+    constexpr int Num_Strings = 500;
+    std::vector<std::vector<huse::InternedString>> results(Num_Threads);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < Num_Threads; ++t)
+    {
+        threads.emplace_back([&, t]() {
+            auto& r = results[t];
+            for (int i = 0; i < Num_Strings; ++i)
+            {
+                // each thread goes in a different order
+                int n = (i * (t + 1) * 7) % Num_Strings;
+                r.push_back(pool.intern("str" + std::to_string(n)));
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    CHECK(pool.stats().strings == Num_Strings);
+    for (int t = 0; t < Num_Threads; ++t)
+    {
+        for (int i = 0; i < Num_Strings; ++i)
+        {
+            int n = (i * (t + 1) * 7) % Num_Strings;
+            auto& h = results[t][i];
+            CHECK(h.str() == "str" + std::to_string(n));
+            CHECK(h == pool.find(h.str()));
+        }
+    }
+}
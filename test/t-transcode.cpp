@@ -0,0 +1,177 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include <doctest/doctest.h>
+
+#include <huse/json/Deserializer.hpp>
+#include <huse/json/Serializer.hpp>
+#include <huse/dom/Deserializer.hpp>
+#include <huse/dom/Serializer.hpp>
+#include <huse/Transcode.hpp>
+
+#include <sstream>
+#include <string>
+
+TEST_SUITE_BEGIN("transcode");
+
+namespace
+{
+std::string jsonToJson(std::string_view json, bool retainSource, bool pretty = false)
+{
+    huse::json::DeserializerOptions opts;
+    opts.retainSource = retainSource;
+    auto d = huse::json::Make_Deserializer(json, opts);
+
+    std::ostringstream out;
+    {
+        auto s = huse::json::Make_Serializer(out, pretty);
+        auto in = d.root();
+        auto o = s.root();
+        huse::transcode(in, o);
+    }
+    return out.str();
+}
+}
+
+TEST_CASE("json to json")
+{
+    constexpr std::string_view pretty = R"json(
+{
+  "int": 5,
+  "neg": -12,
+  "big": 123456789012345,
+  "float": 1.50,
+  "exp": 1e3,
+  "str": "a\/b é \"q\"",
+  "t": true,
+  "f": false,
+  "n": null,
+  "ar": [ 1, [ 2, [] , { } ], { "x": [ 3 , "4" ] }, "]", 5 ],
+  "obj": { "a": { "b": [ null ] }, "c": "}" }
+}
+)json";
+
+    // numbers and strings are copied verbatim
+    CHECK(jsonToJson(pretty, true) ==
+        R"json({"int":5,"neg":-12,"big":123456789012345,"float":1.50,"exp":1e3,"str":"a\/b é \"q\"","t":true,"f":false,"n":null,)json"
+        R"json("ar":[1,[2,[],{}],{"x":[3,"4"]},"]",5],"obj":{"a":{"b":[null]},"c":"}"}})json");
+
+    // the generic path goes through values
+    CHECK(jsonToJson(pretty, false) ==
+        R"json({"int":5,"neg":-12,"big":123456789012345,"float":1.5,"exp":1000,"str":"a/b )json" "\xc3\xa9" R"json( \"q\"","t":true,"f":false,"n":null,)json"
+        R"json("ar":[1,[2,[],{}],{"x":[3,"4"]},"]",5],"obj":{"a":{"b":[null]},"c":"}"}})json");
+
+    // compact to pretty and back
+    auto compact = jsonToJson(pretty, true);
+    auto repretty = jsonToJson(compact, true, true);
+    CHECK(jsonToJson(repretty, true) == compact);
+}
+
+TEST_CASE("json to json big object")
+{
+    // big objects are sorted by the parser, so the source can't be found by order
+    std::string json = "[{";
+    for (int i = 0; i < 150; ++i)
+    {
+        if (i) json += ", ";
+        json += "\"k" + std::to_string(149 - i) + "\": [" + std::to_string(i) + ".0]";
+    }
+    json += "}, 1.0]";
+
+    auto fast = jsonToJson(json, true);
+    auto generic = jsonToJson(json, false);
+    CHECK(fast.size() == generic.size() + 150 * 2 + 2); // ".0" is kept for each value
+    CHECK(fast.find(R"("k149":[0.0])") != std::string::npos);
+    CHECK(fast.find(R"("k0":[149.0])") != std::string::npos);
+    CHECK(fast.substr(fast.size() - 6) == "},1.0]");
+}
+
+TEST_CASE("json to dom to json")
+{
+    constexpr std::string_view json = R"json({"a":[1,2.5,"x",null,true],"b":{"c":-3,"d":[]}})json";
+
+    auto d = huse::json::Make_Deserializer(json);
+    huse::dom::Document doc;
+    {
+        auto s = huse::dom::Make_Serializer(doc);
+        auto in = d.root();
+        auto o = s.root();
+        huse::transcode(in, o);
+    }
+
+    CHECK(doc.root().find("b")->find("c")->asInt() == -3);
+
+    auto dd = huse::dom::Make_Deserializer(doc);
+    std::ostringstream out;
+    {
+        auto s = huse::json::Make_Serializer(out);
+        auto in = dd.root();
+        auto o = s.root();
+        huse::transcode(in, o);
+    }
+    CHECK(out.str() == json);
+}
+
+TEST_CASE("big unsigned")
+{
+    huse::dom::Document doc;
+    {
+        auto s = huse::dom::Make_Serializer(doc);
+        auto root = s.root();
+        auto ar = root.ar();
+        ar.val(UINT64_MAX);
+        ar.val(-5);
+    }
+
+    {
+        auto d = huse::dom::Make_Deserializer(doc);
+        auto root = d.root();
+        auto ar = root.ar();
+        auto q = ar.peeknext();
+        CHECK(q->type().is(huse::Type::UnsignedInteger));
+        CHECK(q->type().is(huse::Type::Integer));
+        q->skip();
+        q = ar.peeknext();
+        CHECK(q->type().is(huse::Type::SignedInteger));
+        CHECK_FALSE(q->type().is(huse::Type::UnsignedInteger));
+        q->skip();
+    }
+
+    huse::dom::Document copy;
+    {
+        auto d = huse::dom::Make_Deserializer(doc);
+        auto s = huse::dom::Make_Serializer(copy);
+        auto in = d.root();
+        auto o = s.root();
+        huse::transcode(in, o);
+    }
+    CHECK(copy.root().element(0).asUInt() == UINT64_MAX);
+    CHECK(copy.root().element(1).asInt() == -5);
+}
+
+TEST_CASE("non-throwing errors")
+{
+    huse::json::DeserializerOptions opts;
+    opts.throwOnError = false;
+
+    for (bool retain : {true, false})
+    {
+        opts.retainSource = retain;
+        auto d = huse::json::Make_Deserializer(std::string_view(R"([1, 2])"), opts);
+
+        std::ostringstream out;
+        {
+            auto s = huse::json::Make_Serializer(out);
+            auto in = d.root();
+            auto o = s.root();
+            auto iar = in.ar();
+            auto oar = o.ar();
+            std::string_view wrong;
+            iar.val(wrong);
+            huse::transcode(iar, oar);
+        }
+        CHECK(huse::errorCode_msg::call(d) == huse::ErrorCode::TypeMismatch);
+        // no empty fragment
+        CHECK(out.str() == "[]");
+    }
+}
@@ -0,0 +1,139 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include <huse/json/Serializer.hpp>
+#include <huse/json/Deserializer.hpp>
+#include <huse/dom/Serializer.hpp>
+#include <huse/dom/Deserializer.hpp>
+#include <huse/Transcode.hpp>
+#include <huse/Exception.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+namespace
+{
+void usage()
+{
+    std::cerr <<
+        "usage: huse-transcode [options] <input.json> [output.json]\n"
+        "reads json and writes it back (to stdout if there is no output file)\n"
+        "options:\n"
+        "  -p, --pretty   pretty output\n"
+        "  -g, --generic  don't copy numbers and strings verbatim\n"
+        "  -d, --dom      go through a huse::dom::Document\n"
+        "  -n <count>     repeat count times and report the average\n";
+}
+
+struct Options
+{
+    bool pretty = false;
+    bool generic = false;
+    bool dom = false;
+    int count = 1;
+    const char* input = nullptr;
+    const char* output = nullptr;
+};
+
+std::string run(const std::string& json, const Options& opts)
+{
+    huse::json::DeserializerOptions dopts;
+    dopts.retainSource = !opts.generic;
+    auto d = huse::json::Make_Deserializer(json, dopts);
+
+    std::ostringstream out;
+    {
+        auto s = huse::json::Make_Serializer(out, opts.pretty);
+        if (opts.dom)
+        {
+            huse::dom::Document doc;
+            {
+                auto ds = huse::dom::Make_Serializer(doc);
+                auto in = d.root();
+                auto mid = ds.root();
+                huse::transcode(in, mid);
+            }
+            auto dd = huse::dom::Make_Deserializer(doc);
+            auto mid = dd.root();
+            auto o = s.root();
+            huse::transcode(mid, o);
+        }
+        else
+        {
+            auto in = d.root();
+            auto o = s.root();
+            huse::transcode(in, o);
+        }
+    }
+    return out.str();
+}
+}
+
+int main(int argc, char* argv[])
+{
+    Options opts;
+    for (int i = 1; i < argc; ++i)
+    {
+        auto arg = argv[i];
+        if (!strcmp(arg, "-p") || !strcmp(arg, "--pretty")) opts.pretty = true;
+        else if (!strcmp(arg, "-g") || !strcmp(arg, "--generic")) opts.generic = true;
+        else if (!strcmp(arg, "-d") || !strcmp(arg, "--dom")) opts.dom = true;
+        else if (!strcmp(arg, "-n") && i + 1 < argc) opts.count = std::max(1, atoi(argv[++i]));
+        else if (arg[0] == '-') { usage(); return 1; }
+        else if (!opts.input) opts.input = arg;
+        else if (!opts.output) opts.output = arg;
+        else { usage(); return 1; }
+    }
+
+    if (!opts.input)
+    {
+        usage();
+        return 1;
+    }
+
+    std::ifstream fin(opts.input, std::ios::binary);
+    if (!fin)
+    {
+        std::cerr << "can't open " << opts.input << '\n';
+        return 1;
+    }
+    std::string json((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+
+    std::string result;
+    try
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < opts.count; ++i)
+        {
+            result = run(json, opts);
+        }
+        auto time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / opts.count;
+
+        auto mb = double(json.size()) / (1024 * 1024);
+        std::cerr << json.size() << " bytes in " << time * 1000 << " ms: " << mb / time << " MB/s\n";
+    }
+    catch (huse::Exception& e)
+    {
+        std::cerr << "error: " << e.what() << '\n';
+        return 1;
+    }
+
+    if (opts.output)
+    {
+        std::ofstream fout(opts.output, std::ios::binary);
+        fout << result;
+    }
+    else
+    {
+        std::cout << result << '\n';
+    }
+
+    return 0;
+}